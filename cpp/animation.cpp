@@ -0,0 +1,238 @@
+#include "./animation.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+/* 4-wide float lanes, lowered to SSE/NEON by the compiler */
+constexpr size_t LANES = 4;
+typedef float Lanes __attribute__((vector_size(LANES * sizeof(float))));
+typedef int32_t LaneMask __attribute__((vector_size(LANES * sizeof(int32_t))));
+
+constexpr uint32_t HANDLE_INDEX_BITS = 24;
+constexpr uint32_t HANDLE_INDEX_MASK = (1 << HANDLE_INDEX_BITS) - 1;
+
+static Lanes load(const float *source) {
+    Lanes result;
+    memcpy(&result, source, sizeof(Lanes));
+    return result;
+}
+
+static void store(float *destination, Lanes value) {
+    memcpy(destination, &value, sizeof(Lanes));
+}
+
+static Lanes splat(float value) {
+    return Lanes{} + value;
+}
+
+static Lanes clamp01(Lanes t) {
+    auto zero = splat(0);
+    auto one = splat(1);
+    LaneMask bits = (LaneMask)t;
+    bits &= ~(LaneMask)(t < zero);
+    LaneMask above = t > one;
+    bits = (bits & ~above) | ((LaneMask)one & above);
+    return (Lanes)bits;
+}
+
+template <Easing E>
+static Lanes ease(Lanes t) {
+    if constexpr (E == Easing::Linear) {
+        return t;
+    } else if constexpr (E == Easing::InQuad) {
+        return t * t;
+    } else if constexpr (E == Easing::OutQuad) {
+        return t * (2.0f - t);
+    } else if constexpr (E == Easing::OutCubic) {
+        auto inv = 1.0f - t;
+        return 1.0f - inv * inv * inv;
+    } else {
+        return t * t * (3.0f - 2.0f * t);
+    }
+}
+
+template <Easing E>
+static void evaluate(
+    size_t count,
+    const float *from,
+    const float *delta,
+    const float *start,
+    const float *inv_duration,
+    float *value,
+    float now
+) {
+    auto now_lanes = splat(now);
+    for (size_t i = 0; i < count; i += LANES) {
+        auto elapsed = now_lanes - load(start + i);
+        auto t = clamp01(elapsed * load(inv_duration + i));
+        store(value + i, load(from + i) + load(delta + i) * ease<E>(t));
+    }
+}
+
+using Evaluator = void (*)(
+    size_t,
+    const float *,
+    const float *,
+    const float *,
+    const float *,
+    float *,
+    float
+);
+constexpr Evaluator EVALUATORS[EASING_COUNT] = {
+    evaluate<Easing::Linear>,
+    evaluate<Easing::InQuad>,
+    evaluate<Easing::OutQuad>,
+    evaluate<Easing::OutCubic>,
+    evaluate<Easing::InOutSmooth>,
+};
+
+void InstanceTransforms::track(Mat4 *matrices, size_t count) {
+    this->matrices = matrices;
+    for (auto &channel : channels) {
+        channel.assign(count, 0);
+    }
+    flags.assign(count, 0);
+    dirty.clear();
+}
+
+void InstanceTransforms::assign(size_t instance, const Mat4 &matrix) {
+    auto &x_axis = matrix[0];
+    auto &y_axis = matrix[1];
+    channels[(size_t)Channel::TranslateX][instance] = matrix[3][0];
+    channels[(size_t)Channel::TranslateY][instance] = matrix[3][1];
+    channels[(size_t)Channel::ScaleX][instance] = hypot(x_axis[0], x_axis[1]);
+    channels[(size_t)Channel::ScaleY][instance] = hypot(y_axis[0], y_axis[1]);
+    channels[(size_t)Channel::Rotation][instance] = atan2(x_axis[1], x_axis[0]);
+}
+
+Mat4 InstanceTransforms::matrix(size_t instance) const {
+    auto value = [&](Channel channel) {
+        return channels[(size_t)channel][instance];
+    };
+    Vec2 translation = {value(Channel::TranslateX), value(Channel::TranslateY)};
+    Vec2 scale = {value(Channel::ScaleX), value(Channel::ScaleY)};
+    return transform_mat4(translation, scale, value(Channel::Rotation));
+}
+
+DirtyRange InstanceTransforms::write_dirty() {
+    if (dirty.empty()) {
+        return {0, 0};
+    }
+
+    size_t first = dirty[0];
+    size_t last = dirty[0];
+    for (auto instance : dirty) {
+        matrices[instance] = matrix(instance);
+        flags[instance] &= ~DIRTY;
+        first = min<size_t>(first, instance);
+        last = max<size_t>(last, instance);
+    }
+    dirty.clear();
+    return {first, last - first + 1};
+}
+
+void Animator::add(
+    InstanceTransforms &transforms,
+    uint32_t instance,
+    Channel channel,
+    float to,
+    float now,
+    float duration,
+    Easing easing
+) {
+    if (handles.size() < transforms.size() * CHANNEL_COUNT) {
+        handles.resize(transforms.size() * CHANNEL_COUNT, 0);
+    }
+
+    auto key = instance * CHANNEL_COUNT + (size_t)channel;
+    if (handles[key]) {
+        auto handle = handles[key] - 1;
+        remove(handle >> HANDLE_INDEX_BITS, handle & HANDLE_INDEX_MASK);
+    }
+
+    auto from = transforms.get(instance, channel);
+    if (duration <= 0) {
+        transforms.set(instance, channel, to);
+        return;
+    }
+
+    auto track_index = (size_t)easing;
+    auto &track = tracks[track_index];
+    auto index = track.instance.size();
+    track.instance.push_back(instance);
+    track.channel.push_back((uint8_t)channel);
+
+    /* Float arrays are padded to whole lanes so batches never read past */
+    if (track.from.size() <= index) {
+        auto padded = track.from.size() * 2 + LANES;
+        track.from.resize(padded, 0);
+        track.delta.resize(padded, 0);
+        track.start.resize(padded, 0);
+        track.inv_duration.resize(padded, 0);
+        track.value.resize(padded, 0);
+    }
+    track.from[index] = from;
+    track.delta[index] = to - from;
+    track.start[index] = now;
+    track.inv_duration[index] = 1 / duration;
+
+    handles[key] = ((track_index << HANDLE_INDEX_BITS) | index) + 1;
+}
+
+void Animator::update(float now, InstanceTransforms &transforms) {
+    for (size_t track_index = 0; track_index < tracks.size(); track_index++) {
+        auto &track = tracks[track_index];
+        auto count = track.instance.size();
+        if (count == 0) {
+            continue;
+        }
+
+        EVALUATORS[track_index](
+            count,
+            track.from.data(),
+            track.delta.data(),
+            track.start.data(),
+            track.inv_duration.data(),
+            track.value.data(),
+            now
+        );
+
+        /* Scatter back to the instances, walking down so removal is safe */
+        for (size_t i = count; i-- > 0;) {
+            transforms.set(
+                track.instance[i], (Channel)track.channel[i], track.value[i]
+            );
+            if ((now - track.start[i]) * track.inv_duration[i] >= 1) {
+                remove(track_index, i);
+            }
+        }
+    }
+}
+
+size_t Animator::active() const {
+    size_t count = 0;
+    for (auto &track : tracks) {
+        count += track.instance.size();
+    }
+    return count;
+}
+
+void Animator::remove(size_t track_index, size_t index) {
+    auto &track = tracks[track_index];
+    auto last = track.instance.size() - 1;
+    handles[track.instance[index] * CHANNEL_COUNT + track.channel[index]] = 0;
+
+    if (index != last) {
+        track.instance[index] = track.instance[last];
+        track.channel[index] = track.channel[last];
+        track.from[index] = track.from[last];
+        track.delta[index] = track.delta[last];
+        track.start[index] = track.start[last];
+        track.inv_duration[index] = track.inv_duration[last];
+        track.value[index] = track.value[last];
+        handles[track.instance[index] * CHANNEL_COUNT + track.channel[index]] =
+            ((track_index << HANDLE_INDEX_BITS) | index) + 1;
+    }
+    track.instance.pop_back();
+    track.channel.pop_back();
+}
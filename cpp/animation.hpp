@@ -0,0 +1,120 @@
+#pragma once
+
+#include "./shape.hpp"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+using namespace std;
+
+enum class Easing : uint8_t {
+    Linear,
+    InQuad,
+    OutQuad,
+    OutCubic,
+    InOutSmooth,
+};
+constexpr size_t EASING_COUNT = 5;
+
+enum class Channel : uint8_t {
+    TranslateX,
+    TranslateY,
+    ScaleX,
+    ScaleY,
+    Rotation,
+};
+constexpr size_t CHANNEL_COUNT = 5;
+
+struct DirtyRange {
+    size_t first;
+    size_t count;
+};
+
+/*
+ * Decomposed view over a matrix array. Instances are decomposed into
+ * channels on first access, so tracking a large scene costs nothing up front.
+ */
+struct InstanceTransforms {
+    static constexpr uint8_t DIRTY = 1;
+    static constexpr uint8_t DECOMPOSED = 2;
+
+    array<vector<float>, CHANNEL_COUNT> channels;
+    vector<uint32_t> dirty;
+    vector<uint8_t> flags;
+    Mat4 *matrices = nullptr;
+
+    void track(Mat4 *matrices, size_t count);
+
+    size_t size() const {
+        return flags.size();
+    }
+
+    float get(size_t instance, Channel channel) {
+        decompose(instance);
+        return channels[(size_t)channel][instance];
+    }
+
+    void set(size_t instance, Channel channel, float value) {
+        decompose(instance);
+        channels[(size_t)channel][instance] = value;
+        if (!(flags[instance] & DIRTY)) {
+            flags[instance] |= DIRTY;
+            dirty.push_back(instance);
+        }
+    }
+
+    void decompose(size_t instance) {
+        if (!(flags[instance] & DECOMPOSED)) {
+            assign(instance, matrices[instance]);
+            flags[instance] |= DECOMPOSED;
+        }
+    }
+
+    /* Decomposes a 2D translate/rotate/scale matrix without marking dirty */
+    void assign(size_t instance, const Mat4 &matrix);
+
+    Mat4 matrix(size_t instance) const;
+
+    /* Recomposes dirty instances into the tracked matrices */
+    DirtyRange write_dirty();
+};
+
+/*
+ * Tweens stored as SoA tracks, one track per easing curve so each batch is
+ * evaluated branch-free. At most one tween is active per instance channel.
+ */
+class Animator {
+  public:
+    void add(
+        InstanceTransforms &transforms,
+        uint32_t instance,
+        Channel channel,
+        float to,
+        float now,
+        float duration,
+        Easing easing = Easing::OutCubic
+    );
+
+    /* Evaluates every active tween at `now` and retires finished ones */
+    void update(float now, InstanceTransforms &transforms);
+
+    size_t active() const;
+
+  private:
+    struct Track {
+        vector<uint32_t> instance;
+        vector<uint8_t> channel;
+        vector<float> from;
+        vector<float> delta;
+        vector<float> start;
+        vector<float> inv_duration;
+        vector<float> value;
+    };
+
+    void remove(size_t track, size_t index);
+
+    array<Track, EASING_COUNT> tracks;
+    /* (instance * CHANNEL_COUNT + channel) -> (track << 24 | index) + 1 */
+    vector<uint32_t> handles;
+};
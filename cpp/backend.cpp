@@ -0,0 +1,78 @@
+#include "./backend.hpp"
+#include <algorithm>
+
+WgpuBackend::WgpuBackend(
+    WGPUQueue queue, const array<WGPUBuffer, BUFFER_COUNT> &buffers
+)
+    : queue(queue), buffers(buffers) {
+}
+
+void WgpuBackend::write_buffer(
+    BufferId buffer, uint64_t offset, const void *data, size_t size
+) {
+    wgpuQueueWriteBuffer(queue, buffers[(size_t)buffer], offset, data, size);
+}
+
+void WgpuBackend::draw(const DrawCall &draw) {
+    auto pipeline = pipelines[(size_t)draw.pipeline];
+    if (pipeline != bound_pipeline) {
+        wgpuRenderBundleEncoderSetPipeline(bundle, pipeline);
+        bound_pipeline = pipeline;
+    }
+    wgpuRenderBundleEncoderDraw(
+        bundle,
+        draw.vertex_count,
+        draw.instance_count,
+        draw.first_vertex,
+        draw.first_instance
+    );
+}
+
+void WgpuBackend::set_bundle_encoder(WGPURenderBundleEncoder bundle) {
+    this->bundle = bundle;
+    bound_pipeline = nullptr;
+}
+
+void WgpuBackend::set_pipelines(
+    const array<WGPURenderPipeline, PIPELINE_COUNT> &pipelines
+) {
+    this->pipelines = pipelines;
+    bound_pipeline = nullptr;
+}
+
+void RecordedFrame::clear() {
+    time = 0;
+    events.clear();
+    uploads.clear();
+    payload.clear();
+    draws.clear();
+}
+
+bool RecordedFrame::empty() const {
+    return events.empty() && uploads.empty() && draws.empty();
+}
+
+bool RecordedFrame::same_output(const RecordedFrame &other) const {
+    auto same_upload = [](const UploadRecord &a, const UploadRecord &b) {
+        return a.buffer == b.buffer && a.size == b.size && a.offset == b.offset;
+    };
+    return ranges::equal(uploads, other.uploads, same_upload) &&
+           ranges::equal(payload, other.payload) &&
+           ranges::equal(draws, other.draws);
+}
+
+void RecordingBackend::write_buffer(
+    BufferId buffer, uint64_t offset, const void *data, size_t size
+) {
+    frame.uploads.push_back({
+        .buffer = buffer,
+        .size = (uint32_t)size,
+        .offset = offset,
+    });
+    auto bytes = static_cast<const byte *>(data);
+    frame.payload.insert(frame.payload.end(), bytes, bytes + size);
+}
+
+void RecordingBackend::draw(const DrawCall &draw) {
+    frame.draws.push_back(draw);
+}
@@ -0,0 +1,104 @@
+#pragma once
+
+#include "./input.hpp"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <webgpu/webgpu.h>
+
+using namespace std;
+
+enum class BufferId : uint32_t {
+    Vertices,
+    Transforms,
+    Colors,
+    /* Instance indices in draw order */
+    Order,
+};
+constexpr size_t BUFFER_COUNT = 4;
+
+enum class PipelineId : uint32_t {
+    Opaque,
+    Transparent,
+};
+constexpr size_t PIPELINE_COUNT = 2;
+
+struct DrawCall {
+    uint32_t vertex_count;
+    uint32_t instance_count;
+    uint32_t first_vertex;
+    uint32_t first_instance;
+    PipelineId pipeline;
+
+    bool operator==(const DrawCall &) const = default;
+};
+
+/* Everything a frame hands to the GPU goes through this interface */
+class FrameBackend {
+  public:
+    virtual ~FrameBackend() = default;
+
+    virtual void write_buffer(
+        BufferId buffer, uint64_t offset, const void *data, size_t size
+    ) = 0;
+    virtual void draw(const DrawCall &draw) = 0;
+};
+
+class WgpuBackend : public FrameBackend {
+  public:
+    WgpuBackend(
+        WGPUQueue queue, const array<WGPUBuffer, BUFFER_COUNT> &buffers
+    );
+
+    void write_buffer(
+        BufferId buffer, uint64_t offset, const void *data, size_t size
+    ) override;
+    void draw(const DrawCall &draw) override;
+
+    /* Draws are recorded into `bundle` until it is replaced */
+    void set_bundle_encoder(WGPURenderBundleEncoder bundle);
+    void set_pipelines(
+        const array<WGPURenderPipeline, PIPELINE_COUNT> &pipelines
+    );
+
+  protected:
+    WGPUQueue queue;
+    WGPURenderBundleEncoder bundle = nullptr;
+
+  private:
+    array<WGPUBuffer, BUFFER_COUNT> buffers;
+    array<WGPURenderPipeline, PIPELINE_COUNT> pipelines = {};
+    WGPURenderPipeline bound_pipeline = nullptr;
+};
+
+struct UploadRecord {
+    BufferId buffer;
+    uint32_t size;
+    uint64_t offset;
+};
+
+/* One frame of input and GPU work, upload payloads packed back to back */
+struct RecordedFrame {
+    float time = 0;
+    vector<InputEvent> events;
+    vector<UploadRecord> uploads;
+    vector<byte> payload;
+    vector<DrawCall> draws;
+
+    void clear();
+    bool empty() const;
+    /* Compares uploads and draws, input is not produced by a frame */
+    bool same_output(const RecordedFrame &other) const;
+};
+
+/* Keeps the frame in memory instead of touching a device */
+class RecordingBackend : public FrameBackend {
+  public:
+    void write_buffer(
+        BufferId buffer, uint64_t offset, const void *data, size_t size
+    ) override;
+    void draw(const DrawCall &draw) override;
+
+    RecordedFrame frame;
+};
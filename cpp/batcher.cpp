@@ -0,0 +1,104 @@
+#include "./batcher.hpp"
+
+static WGPUBuffer create_instance_buffer(
+    MemoryTracker &memory, WGPUDevice device, size_t capacity
+) {
+    WGPUBufferDescriptor buffer_desc = {
+        .nextInChain = nullptr,
+        .label = "quad_instance_buffer",
+        .usage = WGPUBufferUsage_CopyDst | WGPUBufferUsage_Vertex,
+        .size = capacity * sizeof(QuadInstance),
+        .mappedAtCreation = false,
+    };
+    return memory.create_buffer(device, buffer_desc, MemoryCategory::Overlay);
+}
+
+QuadBatcher::QuadBatcher(
+    WGPUDevice device, WGPUQueue queue, MemoryTracker &memory, size_t capacity
+)
+    : device(device), queue(queue), memory(memory), capacity(capacity) {
+    buffer = create_instance_buffer(memory, device, capacity);
+    pending.reserve(capacity);
+    memory.set_host("quad_staging", capacity * sizeof(QuadInstance));
+}
+
+QuadBatcher::~QuadBatcher() {
+    for (auto retired_buffer : retired) {
+        memory.release_buffer(retired_buffer);
+    }
+    memory.release_buffer(buffer);
+    memory.set_host("quad_staging", 0);
+}
+
+void QuadBatcher::begin(WGPURenderPassEncoder pass) {
+    /* The previous frame has been submitted, so its buffers can go */
+    for (auto retired_buffer : retired) {
+        memory.release_buffer(retired_buffer);
+    }
+    retired.clear();
+
+    this->pass = pass;
+    bound_pipeline = nullptr;
+    used = 0;
+    stats = {};
+}
+
+void QuadBatcher::set_pipeline(WGPURenderPipeline pipeline) {
+    if (pipeline == this->pipeline) {
+        return;
+    }
+    if (!pending.empty()) {
+        stats.state_flushes++;
+        flush();
+    }
+    this->pipeline = pipeline;
+}
+
+void QuadBatcher::draw_quad(const Mat4 &transform, const Vec4 &color) {
+    if (used + pending.size() == capacity) {
+        stats.capacity_flushes++;
+        flush();
+        grow();
+    }
+    pending.push_back({transform, color});
+    stats.quads++;
+}
+
+BatchStats QuadBatcher::end() {
+    flush();
+    pass = nullptr;
+    stats.capacity = capacity;
+    return stats;
+}
+
+void QuadBatcher::flush() {
+    if (pending.empty()) {
+        return;
+    }
+
+    auto offset = used * sizeof(QuadInstance);
+    auto size = pending.size() * sizeof(QuadInstance);
+    wgpuQueueWriteBuffer(queue, buffer, offset, pending.data(), size);
+
+    if (bound_pipeline != pipeline) {
+        wgpuRenderPassEncoderSetPipeline(pass, pipeline);
+        bound_pipeline = pipeline;
+    }
+    wgpuRenderPassEncoderSetVertexBuffer(pass, 0, buffer, offset, size);
+    wgpuRenderPassEncoderDraw(pass, 6, pending.size(), 0, 0);
+
+    used += pending.size();
+    stats.draws++;
+    stats.bytes += size;
+    pending.clear();
+}
+
+void QuadBatcher::grow() {
+    /* Earlier draws this frame still read the old buffer */
+    retired.push_back(buffer);
+    capacity *= 2;
+    buffer = create_instance_buffer(memory, device, capacity);
+    pending.reserve(capacity);
+    memory.set_host("quad_staging", capacity * sizeof(QuadInstance));
+    used = 0;
+}
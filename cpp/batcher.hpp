@@ -0,0 +1,72 @@
+#pragma once
+
+#include "./memory_tracker.hpp"
+#include "./shape.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <webgpu/webgpu.h>
+
+using namespace std;
+
+struct QuadInstance {
+    Mat4 transform;
+    Vec4 color;
+};
+
+struct BatchStats {
+    size_t quads;
+    size_t draws;
+    /* Flushes forced by a pipeline change or a full instance buffer */
+    size_t state_flushes;
+    size_t capacity_flushes;
+    size_t bytes;
+    size_t capacity;
+};
+
+/*
+ * Immediate-mode quads, drawn as the unit square of SquareModel. Quads are
+ * staged on the CPU and written into one instance buffer that is reused
+ * across frames, so consecutive quads with the same pipeline become a single
+ * instanced draw. The buffer doubles when a frame outgrows it.
+ */
+class QuadBatcher {
+  public:
+    QuadBatcher(
+        WGPUDevice device,
+        WGPUQueue queue,
+        MemoryTracker &memory,
+        size_t capacity = 256
+    );
+    ~QuadBatcher();
+
+    QuadBatcher(const QuadBatcher &) = delete;
+    QuadBatcher &operator=(const QuadBatcher &) = delete;
+
+    void begin(WGPURenderPassEncoder pass);
+    /* Quads drawn after this use `pipeline`, see create_quad_pipeline */
+    void set_pipeline(WGPURenderPipeline pipeline);
+    void draw_quad(const Mat4 &transform, const Vec4 &color);
+    /* Flushes pending quads, call before the render pass ends */
+    BatchStats end();
+
+  private:
+    void flush();
+    void grow();
+
+    WGPUDevice device;
+    WGPUQueue queue;
+    MemoryTracker &memory;
+    WGPUBuffer buffer = nullptr;
+    size_t capacity;
+    /* Instances already written to `buffer` this frame */
+    size_t used = 0;
+    vector<QuadInstance> pending;
+    /* Outgrown buffers, kept until the frame using them is submitted */
+    vector<WGPUBuffer> retired;
+
+    WGPURenderPassEncoder pass = nullptr;
+    WGPURenderPipeline pipeline = nullptr;
+    WGPURenderPipeline bound_pipeline = nullptr;
+    BatchStats stats = {};
+};
@@ -0,0 +1,229 @@
+#include "./batcher.hpp"
+#include "./draw_sort.hpp"
+#include "./scene_file.hpp"
+#include "./shape.hpp"
+#include "./simulation.hpp"
+#include <GLFW/glfw3.h>
+#include <chrono>
+#include <cstring>
+#include <print>
+#include <string_view>
+#include <vector>
+
+using namespace std;
+
+/*
+ * CPU microbenchmarks, no window or device needed.
+ *
+ *     block_bench [<filter>]
+ *
+ * Runs every benchmark whose name contains <filter> and prints CSV to stdout:
+ *
+ *     benchmark,items,iterations,ns_per_iteration,items_per_second
+ *
+ * `items` is what one iteration processes: matrices, instances, or the
+ * instances of a frame for the frame benchmarks, where ns_per_iteration is
+ * the CPU cost of one frame. Idle frames process nothing, so their `items` is
+ * 0 and items_per_second is left empty.
+ */
+
+using BenchClock = chrono::steady_clock;
+
+constexpr int64_t MIN_BENCH_NS = 200'000'000;
+constexpr size_t MATH_COUNT = 4096;
+constexpr size_t GRID_SIZE = 256;
+
+static volatile float bench_sink;
+
+static string_view filter;
+
+/* Runs `body` in doubling batches until MIN_BENCH_NS have passed */
+template <typename Body>
+static void run(string_view name, size_t items, Body &&body) {
+    if (name.find(filter) == string_view::npos) {
+        return;
+    }
+    body();
+
+    size_t iterations = 0;
+    int64_t elapsed_ns = 0;
+    for (size_t batch = 1; elapsed_ns < MIN_BENCH_NS; batch *= 2) {
+        auto start = BenchClock::now();
+        for (size_t i = 0; i < batch; i++) {
+            body();
+        }
+        elapsed_ns += (BenchClock::now() - start).count();
+        iterations += batch;
+    }
+
+    auto ns_per_iteration = (double)elapsed_ns / iterations;
+    auto items_per_second =
+        items ? format("{:.0f}", items * 1e9 / ns_per_iteration) : "";
+    println(
+        "{},{},{},{:.1f},{}",
+        name,
+        items,
+        iterations,
+        ns_per_iteration,
+        items_per_second
+    );
+}
+
+static float consume(const Mat4 &matrix) {
+    return matrix[0][0] + matrix[3][1];
+}
+
+static void bench_math() {
+    auto matrices = vector<Mat4>(MATH_COUNT);
+    auto vectors = vector<Vec4>(MATH_COUNT);
+    for (size_t i = 0; i < MATH_COUNT; i++) {
+        auto t = (float)i / MATH_COUNT;
+        matrices[i] = transform_mat4({t, -t}, {0.5, 0.25}, t * 3);
+        vectors[i] = Vec4(t, 1 - t, 0.5, 1.0);
+    }
+
+    run("mat_multiply", MATH_COUNT, [&] {
+        float sum = 0;
+        for (size_t i = 0; i < MATH_COUNT; i++) {
+            sum += mat_multiply(matrices[i], vectors[i])[0];
+        }
+        bench_sink = sum;
+    });
+    run("transform_mat4", MATH_COUNT, [&] {
+        float sum = 0;
+        for (size_t i = 0; i < MATH_COUNT; i++) {
+            auto t = vectors[i][0];
+            sum += consume(transform_mat4({t, t}, {1.0, 0.5}, t));
+        }
+        bench_sink = sum;
+    });
+    run("translate_mat4", MATH_COUNT, [&] {
+        float sum = 0;
+        for (auto &matrix : matrices) {
+            sum += consume(translate_mat4(matrix, {0.1, 0.2, 0.0}));
+        }
+        bench_sink = sum;
+    });
+    run("scale_mat4", MATH_COUNT, [&] {
+        float sum = 0;
+        for (auto &matrix : matrices) {
+            sum += consume(scale_mat4(matrix, {0.5, 2.0, 1.0}));
+        }
+        bench_sink = sum;
+    });
+    run("rotate_mat4", MATH_COUNT, [&] {
+        float sum = 0;
+        for (auto &matrix : matrices) {
+            sum += consume(rotate_mat4(matrix, {0.0, 0.3}));
+        }
+        bench_sink = sum;
+    });
+}
+
+static void bench_packing() {
+    constexpr size_t count = GRID_SIZE * GRID_SIZE;
+
+    run("grid_transforms", count, [&] {
+        bench_sink = consume(grid_transforms(GRID_SIZE, GRID_SIZE).back());
+    });
+    run("grid_scene", count, [&] {
+        bench_sink = consume(grid_scene(GRID_SIZE, GRID_SIZE).transforms[0]);
+    });
+
+    /* Interleaving transforms and colors as QuadBatcher stages them */
+    auto scene = grid_scene(GRID_SIZE, GRID_SIZE);
+    auto instances = vector<QuadInstance>();
+    instances.reserve(count);
+    run("pack_quad_instances", count, [&] {
+        instances.clear();
+        for (size_t i = 0; i < count; i++) {
+            instances.push_back({scene.transforms[i], scene.colors[i]});
+        }
+        bench_sink = instances.back().color[0];
+    });
+
+    auto keys = vector<uint64_t>(count);
+    auto order = vector<uint32_t>(count);
+    auto sorter = RadixSorter();
+    run("sort_instances", count, [&] {
+        for (uint32_t i = 0; i < count; i++) {
+            auto depth = scene.transforms[count - 1 - i][3][1] * 0.5f + 0.5f;
+            keys[i] = make_sort_key(RenderPass::Opaque, 0, depth, 0);
+            order[i] = i;
+        }
+        sorter.sort(keys, order);
+        bench_sink = (float)order[0];
+    });
+}
+
+/* Copies uploads into reused staging memory, as the queue would */
+class StagingBackend : public FrameBackend {
+  public:
+    void write_buffer(
+        BufferId, uint64_t, const void *data, size_t size
+    ) override {
+        if (staging.size() < size) {
+            staging.resize(size);
+        }
+        memcpy(staging.data(), data, size);
+        bytes += size;
+    }
+    void draw(const DrawCall &) override {
+        draws++;
+    }
+
+    vector<byte> staging;
+    size_t bytes = 0;
+    size_t draws = 0;
+};
+
+/* Frames as main runs them, minus encoding: update and bundle recording */
+static void bench_frames(size_t width, size_t height) {
+    auto count = width * height;
+    auto data = grid_scene(width, height);
+    auto simulation = Simulation(data.view());
+    auto backend = StagingBackend();
+    auto generation = simulation.draw_generation();
+    float now = 0;
+    simulation.update(now, {}, backend);
+    simulation.draw(backend);
+
+    auto frame = [&](span<const InputEvent> events) {
+        now += 1.0f / 60;
+        simulation.update(now, events, backend);
+        if (simulation.draw_generation() != generation) {
+            generation = simulation.draw_generation();
+            simulation.draw(backend);
+        }
+    };
+    run(format("frame_idle_{}x{}", width, height), 0, [&] {
+        frame({});
+    });
+
+    /* Restarts the rotation whenever it finishes, like holding W */
+    auto press = InputEvent{
+        .type = InputType::Key,
+        .code = GLFW_KEY_W,
+        .action = GLFW_PRESS,
+    };
+    run(format("frame_animating_{}x{}", width, height), count, [&] {
+        if (simulation.animating()) {
+            frame({});
+        } else {
+            frame({&press, 1});
+        }
+    });
+    bench_sink = (float)(backend.bytes + backend.draws);
+}
+
+int main(int argc, char **argv) {
+    if (argc > 1) {
+        filter = argv[1];
+    }
+    println("benchmark,items,iterations,ns_per_iteration,items_per_second");
+    bench_math();
+    bench_packing();
+    bench_frames(4, 4);
+    bench_frames(64, 64);
+    bench_frames(GRID_SIZE, GRID_SIZE);
+}
@@ -0,0 +1,53 @@
+#include "./capabilities.hpp"
+#include "./log.hpp"
+#include <algorithm>
+#include <magic_enum/magic_enum.hpp>
+
+RenderStrategy select_strategy(
+    const WGPULimits &limits, span<const WGPUFeatureName> features
+) {
+    auto strategy = RenderStrategy();
+
+    /* Downlevel backends may have no storage buffers in the vertex stage */
+    auto storage = limits.maxStorageBuffersPerShaderStage >=
+                       INSTANCE_STORAGE_BINDINGS &&
+                   limits.maxStorageBufferBindingSize >= sizeof(Mat4);
+    if (storage) {
+        /* Colors and the draw order are smaller than transforms per instance */
+        strategy.instance_data = InstanceData::Storage;
+        strategy.max_batch_instances = (uint32_t)min<uint64_t>(
+            limits.maxStorageBufferBindingSize / sizeof(Mat4), UINT32_MAX
+        );
+        strategy.buffer_alignment = limits.minStorageBufferOffsetAlignment;
+    } else {
+        /* One uniform block per batch, transforms and colors share it */
+        strategy.instance_data = InstanceData::Uniform;
+        strategy.max_batch_instances =
+            limits.maxUniformBuffersPerShaderStage
+                ? (uint32_t)min<uint64_t>(
+                      limits.maxUniformBufferBindingSize /
+                          UNIFORM_INSTANCE_BYTES,
+                      UINT32_MAX
+                  )
+                : 0;
+        strategy.buffer_alignment = limits.minUniformBufferOffsetAlignment;
+    }
+
+    strategy.timestamp_queries =
+        ranges::count(features, WGPUFeatureName_TimestampQuery) > 0;
+    if (strategy.timestamp_queries) {
+        strategy.required_features.push_back(WGPUFeatureName_TimestampQuery);
+    }
+    return strategy;
+}
+
+void log_strategy(const RenderStrategy &strategy) {
+    LOG_INFO(
+        "strategy: {} instance data, {} instances per binding, {} byte "
+        "alignment, timestamp queries {}",
+        magic_enum::enum_name(strategy.instance_data),
+        strategy.max_batch_instances,
+        strategy.buffer_alignment,
+        strategy.timestamp_queries
+    );
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include "./shape.hpp"
+#include <cstdint>
+#include <span>
+#include <vector>
+#include <webgpu/webgpu.h>
+
+using namespace std;
+
+enum class InstanceData : uint8_t {
+    /* Read-only storage buffers indexed by instance, see shader.wgsl */
+    Storage,
+    /* Fixed-size uniform arrays, for devices without vertex storage */
+    Uniform,
+};
+
+/* Storage buffers `vs_main` binds: transforms, colors and draw order */
+constexpr uint32_t INSTANCE_STORAGE_BINDINGS = 3;
+/* A uniform batch holds a transform and a color per instance */
+constexpr uint64_t UNIFORM_INSTANCE_BYTES = sizeof(Mat4) + sizeof(Vec4);
+
+struct RenderStrategy {
+    InstanceData instance_data;
+    /*
+     * Instances every binding of the path can hold: the whole scene for
+     * storage, one batch for uniform. 0 when the device fits none.
+     */
+    uint32_t max_batch_instances;
+    /* Offset alignment of the instance data bindings */
+    uint32_t buffer_alignment;
+    /* The scene pass is timed on the GPU, see gpu_timer.hpp */
+    bool timestamp_queries;
+    /* Optional features the device has to be requested with */
+    vector<WGPUFeatureName> required_features;
+};
+
+/*
+ * Picks the fastest path the limits and features allow. Pure, so it can be
+ * called with made-up limit tables as well as an adapter's.
+ */
+RenderStrategy select_strategy(
+    const WGPULimits &limits, span<const WGPUFeatureName> features
+);
+
+void log_strategy(const RenderStrategy &strategy);
@@ -0,0 +1,123 @@
+#include "./capabilities.hpp"
+#include "./shape.hpp"
+#include <cstdint>
+#include <print>
+#include <vector>
+
+using namespace std;
+
+/*
+ * Checks select_strategy against made-up limit tables and feature lists,
+ * no device needed.
+ *
+ *     capabilities_test
+ *
+ * Prints every failed check to stderr and exits with 1 if any failed.
+ */
+
+static int failures = 0;
+
+static void check(bool passed, const char *name) {
+    if (!passed) {
+        println(stderr, "FAIL {}", name);
+        failures++;
+    }
+}
+
+/* Limits of a desktop adapter, with vertex storage buffers */
+static WGPULimits desktop_limits() {
+    auto limits = WGPULimits();
+    limits.maxStorageBuffersPerShaderStage = 8;
+    limits.maxStorageBufferBindingSize = 128 << 20;
+    limits.maxUniformBuffersPerShaderStage = 12;
+    limits.maxUniformBufferBindingSize = 64 << 10;
+    limits.minUniformBufferOffsetAlignment = 256;
+    limits.minStorageBufferOffsetAlignment = 64;
+    return limits;
+}
+
+static void test_storage() {
+    auto strategy = select_strategy(desktop_limits(), {});
+    check(strategy.instance_data == InstanceData::Storage, "storage");
+    check(
+        strategy.max_batch_instances == (128 << 20) / sizeof(Mat4),
+        "storage instances"
+    );
+    check(strategy.buffer_alignment == 64, "storage alignment");
+
+    auto limits = desktop_limits();
+    limits.maxStorageBuffersPerShaderStage = INSTANCE_STORAGE_BINDINGS;
+    check(
+        select_strategy(limits, {}).instance_data == InstanceData::Storage,
+        "storage with exactly the bindings needed"
+    );
+
+    limits.maxStorageBufferBindingSize = UINT64_MAX;
+    check(
+        select_strategy(limits, {}).max_batch_instances == UINT32_MAX,
+        "storage instances clamped"
+    );
+}
+
+static void test_uniform() {
+    /* Downlevel backends report no storage buffers at all */
+    auto limits = desktop_limits();
+    limits.maxStorageBuffersPerShaderStage = 0;
+    limits.maxStorageBufferBindingSize = 0;
+    auto strategy = select_strategy(limits, {});
+    check(strategy.instance_data == InstanceData::Uniform, "uniform");
+    check(
+        strategy.max_batch_instances == (64 << 10) / UNIFORM_INSTANCE_BYTES,
+        "uniform instances fit transforms and colors"
+    );
+    check(strategy.buffer_alignment == 256, "uniform alignment");
+
+    limits.maxUniformBuffersPerShaderStage = 0;
+    check(
+        select_strategy(limits, {}).max_batch_instances == 0,
+        "no instances without uniform buffers"
+    );
+
+    limits = desktop_limits();
+    limits.maxStorageBuffersPerShaderStage = INSTANCE_STORAGE_BINDINGS - 1;
+    check(
+        select_strategy(limits, {}).instance_data == InstanceData::Uniform,
+        "uniform with too few storage bindings"
+    );
+
+    limits = desktop_limits();
+    limits.maxStorageBufferBindingSize = sizeof(Mat4) - 1;
+    check(
+        select_strategy(limits, {}).instance_data == InstanceData::Uniform,
+        "uniform when no transform fits a storage binding"
+    );
+}
+
+static void test_features() {
+    auto strategy = select_strategy(desktop_limits(), {});
+    check(!strategy.timestamp_queries, "no timestamp queries");
+    check(strategy.required_features.empty(), "no required features");
+
+    WGPUFeatureName features[] = {
+        WGPUFeatureName_Depth32FloatStencil8,
+        WGPUFeatureName_TimestampQuery,
+    };
+    strategy = select_strategy(desktop_limits(), features);
+    check(strategy.timestamp_queries, "timestamp queries");
+    check(
+        strategy.required_features ==
+            vector{WGPUFeatureName_TimestampQuery},
+        "only used features required"
+    );
+}
+
+int main() {
+    test_storage();
+    test_uniform();
+    test_features();
+    if (failures) {
+        println(stderr, "{} checks failed", failures);
+        return 1;
+    }
+    println("all checks passed");
+}
@@ -0,0 +1,183 @@
+#include "./capture.hpp"
+#include "./simulation.hpp"
+#include <algorithm>
+#include <cstring>
+#include <format>
+#include <print>
+#include <stdexcept>
+#include <vector>
+
+template <typename T>
+static void write_array(ofstream &file, const vector<T> &values) {
+    file.write(
+        reinterpret_cast<const char *>(values.data()), values.size() * sizeof(T)
+    );
+}
+
+/* Checks `count` against what is left of the file before allocating */
+template <typename Array>
+static void read_array(
+    ifstream &file, uint64_t file_size, Array &values, uint64_t count
+) {
+    using T = typename Array::value_type;
+    auto position = (int64_t)file.tellg();
+    if (position < 0 || count > (file_size - (uint64_t)position) / sizeof(T)) {
+        throw runtime_error("capture is truncated");
+    }
+    values.resize(count);
+    file.read(reinterpret_cast<char *>(values.data()), count * sizeof(T));
+}
+
+CaptureBackend::CaptureBackend(
+    const filesystem::path &path, const string &scene_path, FrameBackend &target
+)
+    : file(path, ios::binary | ios::trunc), target(target) {
+    if (!file.is_open()) {
+        throw runtime_error(format("failed opening {}", path.string()));
+    }
+    CaptureHeader header = {
+        .magic = {},
+        .version = CAPTURE_VERSION,
+        .scene_path_size = (uint32_t)scene_path.size(),
+    };
+    memcpy(header.magic, CAPTURE_MAGIC, sizeof(CAPTURE_MAGIC));
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    file.write(scene_path.data(), scene_path.size());
+}
+
+CaptureBackend::~CaptureBackend() {
+    end_frame();
+}
+
+void CaptureBackend::begin_frame(float time, span<const InputEvent> events) {
+    end_frame();
+    recording.frame.time = time;
+    recording.frame.events.assign(events.begin(), events.end());
+}
+
+void CaptureBackend::write_buffer(
+    BufferId buffer, uint64_t offset, const void *data, size_t size
+) {
+    recording.write_buffer(buffer, offset, data, size);
+    target.write_buffer(buffer, offset, data, size);
+}
+
+void CaptureBackend::draw(const DrawCall &draw) {
+    recording.draw(draw);
+}
+
+void CaptureBackend::end_frame() {
+    auto &frame = recording.frame;
+    if (!frame.empty()) {
+        CaptureFrame header = {
+            .time = frame.time,
+            .event_count = (uint32_t)frame.events.size(),
+            .upload_count = (uint32_t)frame.uploads.size(),
+            .draw_count = (uint32_t)frame.draws.size(),
+            .payload_size = frame.payload.size(),
+        };
+        file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        write_array(file, frame.events);
+        write_array(file, frame.uploads);
+        write_array(file, frame.payload);
+        write_array(file, frame.draws);
+    }
+    frame.clear();
+}
+
+CaptureReader::CaptureReader(const filesystem::path &path)
+    : file(path, ios::binary) {
+    if (!file.is_open()) {
+        throw runtime_error(format("failed opening {}", path.string()));
+    }
+    file_size = filesystem::file_size(path);
+    CaptureHeader header;
+    file.read(reinterpret_cast<char *>(&header), sizeof(header));
+    if (!file || memcmp(header.magic, CAPTURE_MAGIC, sizeof(CAPTURE_MAGIC))) {
+        throw runtime_error(format("{} is not a capture", path.string()));
+    }
+    if (header.version != CAPTURE_VERSION) {
+        throw runtime_error(
+            format("unsupported capture version {}", header.version)
+        );
+    }
+    read_array(file, file_size, scene, header.scene_path_size);
+    if (!file) {
+        throw runtime_error("capture is truncated");
+    }
+}
+
+bool CaptureReader::next(RecordedFrame &frame) {
+    CaptureFrame header;
+    file.read(reinterpret_cast<char *>(&header), sizeof(header));
+    if (file.gcount() == 0 && file.eof()) {
+        return false;
+    }
+    if (file.gcount() != sizeof(header)) {
+        throw runtime_error("capture is truncated");
+    }
+    frame.time = header.time;
+    read_array(file, file_size, frame.events, header.event_count);
+    read_array(file, file_size, frame.uploads, header.upload_count);
+    read_array(file, file_size, frame.payload, header.payload_size);
+    read_array(file, file_size, frame.draws, header.draw_count);
+    if (!file) {
+        throw runtime_error("capture is truncated");
+    }
+    return true;
+}
+
+size_t replay_capture(CaptureReader &reader, const SceneView &scene) {
+    auto simulation = Simulation(scene);
+    auto backend = RecordingBackend();
+    auto captured = RecordedFrame();
+    auto frame_ns = vector<int64_t>();
+    size_t mismatched = 0;
+
+    println("frame,time,events,uploads,upload_bytes,draws,cpu_ns,match");
+    while (reader.next(captured)) {
+        backend.frame.clear();
+
+        auto start_ns = now_ns();
+        simulation.update(captured.time, captured.events, backend);
+        if (!captured.draws.empty()) {
+            simulation.draw(backend);
+        }
+        auto cpu_ns = now_ns() - start_ns;
+
+        auto match = backend.frame.same_output(captured);
+        mismatched += !match;
+        println(
+            "{},{:.6f},{},{},{},{},{},{}",
+            frame_ns.size(),
+            captured.time,
+            captured.events.size(),
+            backend.frame.uploads.size(),
+            backend.frame.payload.size(),
+            backend.frame.draws.size(),
+            cpu_ns,
+            (int)match
+        );
+        frame_ns.push_back(cpu_ns);
+    }
+
+    if (!frame_ns.empty()) {
+        auto total_ns = 0.0;
+        for (auto ns : frame_ns) {
+            total_ns += ns;
+        }
+        ranges::sort(frame_ns);
+        println(
+            stderr,
+            "replayed {} frames: mean {:.0f}ns, p50 {}ns, p99 {}ns, max {}ns, "
+            "{} mismatched",
+            frame_ns.size(),
+            total_ns / frame_ns.size(),
+            frame_ns[frame_ns.size() / 2],
+            frame_ns[frame_ns.size() * 99 / 100],
+            frame_ns.back(),
+            mismatched
+        );
+    }
+    return mismatched;
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include "./backend.hpp"
+#include "./scene_file.hpp"
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+using namespace std;
+
+/*
+ * Capture layout, little-endian:
+ *
+ *     CaptureHeader, followed by the scene path
+ *     per frame: CaptureFrame, InputEvent[event_count],
+ *         UploadRecord[upload_count], payload bytes, DrawCall[draw_count]
+ *
+ * Frames without input, uploads or draws are not stored.
+ */
+constexpr char CAPTURE_MAGIC[8] = {'B', 'L', 'K', 'C', 'A', 'P', 'T', 'R'};
+constexpr uint32_t CAPTURE_VERSION = 2;
+
+struct CaptureHeader {
+    char magic[8];
+    uint32_t version;
+    /* Empty for the built-in scene */
+    uint32_t scene_path_size;
+};
+
+struct CaptureFrame {
+    float time;
+    uint32_t event_count;
+    uint32_t upload_count;
+    uint32_t draw_count;
+    uint64_t payload_size;
+};
+
+/*
+ * Records every frame. Uploads pass through to `target`, draws are only
+ * recorded because the device replays them from a render bundle.
+ */
+class CaptureBackend : public FrameBackend {
+  public:
+    CaptureBackend(
+        const filesystem::path &path,
+        const string &scene_path,
+        FrameBackend &target
+    );
+    ~CaptureBackend();
+
+    /* Ends the previous frame */
+    void begin_frame(float time, span<const InputEvent> events);
+
+    void write_buffer(
+        BufferId buffer, uint64_t offset, const void *data, size_t size
+    ) override;
+    void draw(const DrawCall &draw) override;
+
+  private:
+    void end_frame();
+
+    ofstream file;
+    FrameBackend &target;
+    RecordingBackend recording;
+};
+
+/* Throws runtime_error on malformed captures */
+class CaptureReader {
+  public:
+    explicit CaptureReader(const filesystem::path &path);
+
+    const string &scene_path() const {
+        return scene;
+    }
+
+    /* Returns false at the end of the capture */
+    bool next(RecordedFrame &frame);
+
+  private:
+    ifstream file;
+    uint64_t file_size;
+    string scene;
+};
+
+/*
+ * Re-executes every captured frame against a RecordingBackend as fast as
+ * possible. Prints a CSV row with the CPU time of each frame to stdout and
+ * returns how many frames produced different uploads or draws.
+ */
+size_t replay_capture(CaptureReader &reader, const SceneView &scene);
@@ -0,0 +1,145 @@
+#include "./capture.hpp"
+#include "./simulation.hpp"
+#include <GLFW/glfw3.h>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <print>
+#include <stdexcept>
+#include <vector>
+
+using namespace std;
+
+/*
+ * Captures frames of the built-in grid, replays them and checks that
+ * truncated or corrupt captures are rejected with runtime_error.
+ *
+ *     capture_test
+ *
+ * Prints every failed check to stderr and exits with 1 if any failed.
+ */
+
+static int failures = 0;
+
+static void check(bool passed, const string &name) {
+    if (!passed) {
+        println(stderr, "FAIL {}", name);
+        failures++;
+    }
+}
+
+static const auto CAPTURE_PATH =
+    filesystem::temp_directory_path() / "capture_test.cap";
+
+/* Holds W for a while, so frames have input, uploads and draws */
+static void write_capture(const SceneView &scene) {
+    auto target = RecordingBackend();
+    auto capture = CaptureBackend(CAPTURE_PATH, "", target);
+    auto simulation = Simulation(scene);
+    auto press = InputEvent{
+        .type = InputType::Key,
+        .code = GLFW_KEY_W,
+        .action = GLFW_PRESS,
+    };
+    for (int frame = 0; frame < 30; frame++) {
+        auto now = frame / 60.0f;
+        auto events = span<const InputEvent>();
+        if (frame == 2) {
+            events = {&press, 1};
+        }
+        capture.begin_frame(now, events);
+        simulation.update(now, events, capture);
+        simulation.draw(capture);
+    }
+}
+
+static vector<char> read_file(const filesystem::path &path) {
+    auto file = ifstream(path, ios::binary);
+    return {istreambuf_iterator<char>(file), istreambuf_iterator<char>()};
+}
+
+static void write_file(const filesystem::path &path, span<const char> bytes) {
+    auto file = ofstream(path, ios::binary | ios::trunc);
+    file.write(bytes.data(), bytes.size());
+}
+
+/* True when reading every frame of `bytes` throws runtime_error */
+static bool rejected(span<const char> bytes) {
+    write_file(CAPTURE_PATH, bytes);
+    try {
+        auto reader = CaptureReader(CAPTURE_PATH);
+        auto frame = RecordedFrame();
+        while (reader.next(frame)) {
+        }
+    } catch (const runtime_error &) {
+        return true;
+    }
+    return false;
+}
+
+static void test_round_trip() {
+    /* The simulation animates its scene in place, so each run gets a copy */
+    auto captured = grid_scene(4, 4);
+    write_capture(captured.view());
+    auto replayed = grid_scene(4, 4);
+    auto reader = CaptureReader(CAPTURE_PATH);
+    check(
+        replay_capture(reader, replayed.view()) == 0,
+        "replay matches the capture"
+    );
+}
+
+static void test_malformed() {
+    auto bytes = read_file(CAPTURE_PATH);
+    auto frame_offset = sizeof(CaptureHeader);
+    check(!rejected(bytes), "complete capture");
+
+    for (auto size : {
+             (size_t)0,
+             sizeof(CaptureHeader) - 4,
+             frame_offset + 4,
+             frame_offset + sizeof(CaptureFrame) - 1,
+             frame_offset + sizeof(CaptureFrame) + 1,
+             bytes.size() - 1,
+         }) {
+        check(
+            rejected(span(bytes).first(size)),
+            format("truncated to {} bytes", size)
+        );
+    }
+
+    auto corrupt = [&](size_t offset, uint64_t value, size_t size) {
+        auto copy = bytes;
+        memcpy(copy.data() + offset, &value, size);
+        return rejected(copy);
+    };
+    check(
+        corrupt(offsetof(CaptureHeader, scene_path_size), UINT32_MAX, 4),
+        "corrupt scene path size"
+    );
+    auto field = [&](size_t offset) { return frame_offset + offset; };
+    check(
+        corrupt(field(offsetof(CaptureFrame, event_count)), 1 << 30, 4),
+        "corrupt event count"
+    );
+    check(
+        corrupt(field(offsetof(CaptureFrame, draw_count)), UINT32_MAX, 4),
+        "corrupt draw count"
+    );
+    check(
+        corrupt(field(offsetof(CaptureFrame, payload_size)), UINT64_MAX, 8),
+        "corrupt payload size"
+    );
+}
+
+int main() {
+    test_round_trip();
+    test_malformed();
+    filesystem::remove(CAPTURE_PATH);
+    if (failures) {
+        println(stderr, "{} checks failed", failures);
+        return 1;
+    }
+    println(stderr, "all checks passed");
+}
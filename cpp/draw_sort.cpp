@@ -0,0 +1,151 @@
+#include "./draw_sort.hpp"
+#include <algorithm>
+#include <cstring>
+#include <thread>
+
+constexpr uint32_t RADIX_BITS = 8;
+constexpr size_t PARALLEL_THRESHOLD = 1 << 16;
+/* Below this, clearing 256-entry histograms costs more than the sort */
+constexpr size_t INSERTION_THRESHOLD = 64;
+
+constexpr uint32_t MATERIAL_SHIFT = 0;
+constexpr uint32_t DEPTH_SHIFT = MATERIAL_SHIFT + SORT_MATERIAL_BITS;
+constexpr uint32_t PIPELINE_SHIFT = DEPTH_SHIFT + SORT_DEPTH_BITS;
+constexpr uint32_t PASS_SHIFT = PIPELINE_SHIFT + SORT_PIPELINE_BITS;
+
+static constexpr uint64_t bit_mask(uint32_t bits) {
+    return (uint64_t(1) << bits) - 1;
+}
+
+uint64_t make_sort_key(
+    RenderPass pass, uint32_t pipeline, float depth, uint32_t material
+) {
+    constexpr auto DEPTH_MAX = bit_mask(SORT_DEPTH_BITS);
+    auto quantized = (uint64_t)(clamp(depth, 0.0f, 1.0f) * DEPTH_MAX);
+    if (pass == RenderPass::Transparent) {
+        quantized = DEPTH_MAX - quantized;
+    }
+    return (uint64_t)pass << PASS_SHIFT |
+           (pipeline & bit_mask(SORT_PIPELINE_BITS)) << PIPELINE_SHIFT |
+           quantized << DEPTH_SHIFT |
+           (material & bit_mask(SORT_MATERIAL_BITS)) << MATERIAL_SHIFT;
+}
+
+RenderPass sort_key_pass(uint64_t key) {
+    return (RenderPass)(key >> PASS_SHIFT);
+}
+
+uint32_t sort_key_pipeline(uint64_t key) {
+    return (key >> PIPELINE_SHIFT) & bit_mask(SORT_PIPELINE_BITS);
+}
+
+uint32_t sort_key_material(uint64_t key) {
+    return (key >> MATERIAL_SHIFT) & bit_mask(SORT_MATERIAL_BITS);
+}
+
+RadixSorter::RadixSorter(size_t threads)
+    : max_threads(threads ? threads : max(1u, thread::hardware_concurrency())) {
+}
+
+void RadixSorter::sort(span<uint64_t> keys, span<uint32_t> values) {
+    count = keys.size();
+    if (count < INSERTION_THRESHOLD) {
+        for (size_t i = 1; i < count; i++) {
+            auto key = keys[i];
+            auto value = values[i];
+            auto j = i;
+            for (; j > 0 && keys[j - 1] > key; j--) {
+                keys[j] = keys[j - 1];
+                values[j] = values[j - 1];
+            }
+            keys[j] = key;
+            values[j] = value;
+        }
+        return;
+    }
+    key_scratch.resize(count);
+    value_scratch.resize(count);
+    thread_count = count >= PARALLEL_THRESHOLD ? max_threads : 1;
+    histograms.resize(thread_count);
+
+    source_keys = keys.data();
+    source_values = values.data();
+    target_keys = key_scratch.data();
+    target_values = value_scratch.data();
+    shift = 0;
+    skip = false;
+    scattering = false;
+
+    if (thread_count == 1) {
+        sort_range(0);
+    } else {
+        /* Started on the first large sort, then reused */
+        if (!pool) {
+            pool.emplace(max_threads);
+            sync.emplace(max_threads, Advance{this});
+            job = [this](size_t thread_index) { sort_range(thread_index); };
+        }
+        /* One job per pool thread, each blocks in the barrier until all run */
+        pool->run(max_threads, job);
+    }
+
+    if (source_keys != keys.data()) {
+        memcpy(keys.data(), source_keys, count * sizeof(uint64_t));
+        memcpy(values.data(), source_values, count * sizeof(uint32_t));
+    }
+}
+
+void RadixSorter::advance() noexcept {
+    if (!scattering) {
+        /* Histograms become each thread's first output index per digit */
+        size_t offset = 0;
+        skip = false;
+        for (size_t digit = 0; digit < RADIX; digit++) {
+            auto digit_start = offset;
+            for (auto &histogram : histograms) {
+                auto digit_count = histogram[digit];
+                histogram[digit] = offset;
+                offset += digit_count;
+            }
+            skip |= offset - digit_start == count;
+        }
+    } else {
+        if (!skip) {
+            swap(source_keys, target_keys);
+            swap(source_values, target_values);
+        }
+        shift += RADIX_BITS;
+    }
+    scattering = !scattering;
+}
+
+void RadixSorter::wait_phase() {
+    if (thread_count == 1) {
+        advance();
+    } else {
+        sync->arrive_and_wait();
+    }
+}
+
+void RadixSorter::sort_range(size_t thread_index) {
+    auto begin = count * thread_index / thread_count;
+    auto end = count * (thread_index + 1) / thread_count;
+    auto &histogram = histograms[thread_index];
+    while (shift < 64) {
+        histogram.fill(0);
+        for (auto i = begin; i < end; i++) {
+            histogram[(source_keys[i] >> shift) & (RADIX - 1)]++;
+        }
+        wait_phase();
+
+        if (!skip) {
+            for (auto i = begin; i < end; i++) {
+                auto digit = (source_keys[i] >> shift) & (RADIX - 1);
+                auto index = histogram[digit]++;
+                target_keys[index] = source_keys[i];
+                target_values[index] = source_values[i];
+            }
+        }
+        wait_phase();
+    }
+}
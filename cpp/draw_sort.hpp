@@ -0,0 +1,92 @@
+#pragma once
+
+#include "./worker_pool.hpp"
+#include <array>
+#include <barrier>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <span>
+#include <vector>
+
+using namespace std;
+
+enum class RenderPass : uint8_t {
+    Opaque,
+    Transparent,
+};
+
+/*
+ * Sort key, most significant first:
+ *
+ *     pass      2 bits
+ *     pipeline 10 bits
+ *     depth    24 bits, front to back for opaque, back to front otherwise
+ *     material 28 bits
+ *
+ * Sorting keys ascending groups draws by pass and pipeline, orders them by
+ * depth within a pipeline and keeps equal materials adjacent.
+ */
+constexpr uint32_t SORT_PIPELINE_BITS = 10;
+constexpr uint32_t SORT_DEPTH_BITS = 24;
+constexpr uint32_t SORT_MATERIAL_BITS = 28;
+
+/* `depth` is clip-space z in [0, 1], values outside are clamped */
+uint64_t make_sort_key(
+    RenderPass pass, uint32_t pipeline, float depth, uint32_t material
+);
+
+RenderPass sort_key_pass(uint64_t key);
+uint32_t sort_key_pipeline(uint64_t key);
+uint32_t sort_key_material(uint64_t key);
+
+/*
+ * Stable LSD radix sort over 8-bit digits, carrying a value per key. Inputs
+ * above a threshold are split across a persistent pool, each thread building
+ * a histogram of its chunk and scattering it to offsets derived from all
+ * histograms. Digits that are equal for every key are skipped, and small
+ * inputs use insertion sort. Scratch memory and threads are reused.
+ */
+class RadixSorter {
+  public:
+    /* 0 uses the hardware concurrency */
+    explicit RadixSorter(size_t threads = 0);
+
+    void sort(span<uint64_t> keys, span<uint32_t> values);
+
+  private:
+    static constexpr size_t RADIX = 256;
+
+    /* Barrier completion, moves every thread to the next phase */
+    struct Advance {
+        RadixSorter *sorter;
+        void operator()() noexcept {
+            sorter->advance();
+        }
+    };
+
+    void advance() noexcept;
+    void wait_phase();
+    void sort_range(size_t thread_index);
+
+    size_t max_threads;
+    vector<uint64_t> key_scratch;
+    vector<uint32_t> value_scratch;
+    vector<array<size_t, RADIX>> histograms;
+
+    /* State of the sort in progress, shared by its threads */
+    size_t count = 0;
+    size_t thread_count = 1;
+    uint64_t *source_keys = nullptr;
+    uint32_t *source_values = nullptr;
+    uint64_t *target_keys = nullptr;
+    uint32_t *target_values = nullptr;
+    uint32_t shift = 0;
+    bool skip = false;
+    bool scattering = false;
+
+    optional<WorkerPool> pool;
+    optional<barrier<Advance>> sync;
+    function<void(size_t)> job;
+};
@@ -0,0 +1,70 @@
+#include "./encoding.hpp"
+
+SceneBundle::SceneBundle(
+    WGPUDevice device,
+    WGPUTextureFormat color_format,
+    WGPUTextureFormat depth_format
+)
+    : device(device), color_format(color_format), depth_format(depth_format) {
+}
+
+SceneBundle::~SceneBundle() {
+    invalidate();
+}
+
+void SceneBundle::invalidate() {
+    if (bundle) {
+        wgpuRenderBundleRelease(bundle);
+        bundle = nullptr;
+    }
+}
+
+WGPURenderBundle
+SceneBundle::get(uint64_t generation, const RecordBundle &record) {
+    if (bundle && generation == this->generation) {
+        return bundle;
+    }
+    invalidate();
+
+    WGPURenderBundleEncoderDescriptor encoder_desc = {
+        .label = "scene_bundle",
+        .colorFormatCount = 1,
+        .colorFormats = &color_format,
+        .depthStencilFormat = depth_format,
+        .sampleCount = 1,
+        .depthReadOnly = false,
+        .stencilReadOnly = false,
+    };
+    auto encoder = wgpuDeviceCreateRenderBundleEncoder(device, &encoder_desc);
+    record(encoder);
+    bundle = wgpuRenderBundleEncoderFinish(encoder, nullptr);
+    wgpuRenderBundleEncoderRelease(encoder);
+
+    this->generation = generation;
+    record_count++;
+    return bundle;
+}
+
+ParallelEncoder::ParallelEncoder(
+    WGPUDevice device, WGPUQueue queue, size_t threads
+)
+    : device(device), queue(queue), pool(threads) {
+    /* Built once, a capturing temporary would allocate every frame */
+    record = [this](size_t index) {
+        auto encoder = wgpuDeviceCreateCommandEncoder(this->device, nullptr);
+        passes[index](encoder);
+        command_buffers[index] = wgpuCommandEncoderFinish(encoder, nullptr);
+        wgpuCommandEncoderRelease(encoder);
+    };
+}
+
+void ParallelEncoder::submit(span<const RecordPass> passes) {
+    this->passes = passes;
+    command_buffers.resize(passes.size());
+    pool.run(passes.size(), record);
+
+    wgpuQueueSubmit(queue, command_buffers.size(), command_buffers.data());
+    for (auto command_buffer : command_buffers) {
+        wgpuCommandBufferRelease(command_buffer);
+    }
+}
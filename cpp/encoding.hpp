@@ -0,0 +1,66 @@
+#pragma once
+
+#include "./worker_pool.hpp"
+#include <cstdint>
+#include <functional>
+#include <span>
+#include <vector>
+#include <webgpu/webgpu.h>
+
+using namespace std;
+
+using RecordBundle = function<void(WGPURenderBundleEncoder)>;
+using RecordPass = function<void(WGPUCommandEncoder)>;
+
+/*
+ * Static draws recorded once into a render bundle and replayed every frame.
+ * The bundle is re-recorded when its generation changes or it is
+ * invalidated, e.g. after the pipelines it uses were reloaded.
+ */
+class SceneBundle {
+  public:
+    SceneBundle(
+        WGPUDevice device,
+        WGPUTextureFormat color_format,
+        WGPUTextureFormat depth_format
+    );
+    ~SceneBundle();
+
+    SceneBundle(const SceneBundle &) = delete;
+    SceneBundle &operator=(const SceneBundle &) = delete;
+
+    void invalidate();
+    WGPURenderBundle get(uint64_t generation, const RecordBundle &record);
+
+    size_t recorded() const {
+        return record_count;
+    }
+
+  private:
+    WGPUDevice device;
+    WGPUTextureFormat color_format;
+    WGPUTextureFormat depth_format;
+    WGPURenderBundle bundle = nullptr;
+    uint64_t generation = 0;
+    size_t record_count = 0;
+};
+
+/*
+ * Records passes on a worker pool, each into its own command encoder, and
+ * submits their command buffers together in the order the passes were
+ * given, so the GPU sees the same sequence however the threads ran.
+ */
+class ParallelEncoder {
+  public:
+    ParallelEncoder(WGPUDevice device, WGPUQueue queue, size_t threads = 0);
+
+    void submit(span<const RecordPass> passes);
+
+  private:
+    WGPUDevice device;
+    WGPUQueue queue;
+    WorkerPool pool;
+    function<void(size_t)> record;
+    span<const RecordPass> passes;
+    vector<WGPUCommandBuffer> command_buffers;
+};
@@ -1,6 +1,52 @@
+#include "./extension.hpp"
 #include <chrono>
 #include <thread>
 
 void sleep(int ms) {
     std::this_thread::sleep_for(std::chrono::milliseconds(ms));
 }
+
+std::chrono::nanoseconds sleep_until_precise(
+    std::chrono::steady_clock::time_point deadline,
+    std::chrono::nanoseconds spin
+) {
+    auto oversleep = std::chrono::nanoseconds(0);
+    auto coarse_deadline = deadline - spin;
+    if (std::chrono::steady_clock::now() < coarse_deadline) {
+        std::this_thread::sleep_until(coarse_deadline);
+        oversleep = std::chrono::steady_clock::now() - coarse_deadline;
+    }
+    while (std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::yield();
+    }
+    return oversleep;
+}
+
+FileWatcher::FileWatcher(
+    std::filesystem::path path, std::chrono::nanoseconds interval
+)
+    : path(std::move(path)), interval(interval),
+      last_check(std::chrono::steady_clock::now()) {
+    auto error = std::error_code();
+    last_write = std::filesystem::last_write_time(this->path, error);
+}
+
+bool FileWatcher::changed() {
+    auto now = std::chrono::steady_clock::now();
+    if (now - last_check < interval) {
+        return false;
+    }
+    last_check = now;
+
+    auto error = std::error_code();
+    auto write_time = std::filesystem::last_write_time(path, error);
+    if (error || write_time == last_write) {
+        return false;
+    }
+    last_write = write_time;
+    return true;
+}
+
+void FileWatcher::rearm() {
+    last_write = {};
+}
@@ -1,3 +1,32 @@
 #pragma once
 
+#include <chrono>
+#include <filesystem>
+
 void sleep(int ms);
+
+/*
+ * Sleeps until `spin` before `deadline`, then busy-waits the remainder.
+ * Returns how far the OS sleep overshot its own wake-up time.
+ */
+std::chrono::nanoseconds sleep_until_precise(
+    std::chrono::steady_clock::time_point deadline,
+    std::chrono::nanoseconds spin
+);
+
+/* Polls a file's modification time at most once per `interval` */
+class FileWatcher {
+  public:
+    FileWatcher(std::filesystem::path path, std::chrono::nanoseconds interval);
+
+    /* True once per observed change, false while the file is missing */
+    bool changed();
+    /* Reports the file as changed on the next check it exists */
+    void rearm();
+
+  private:
+    std::filesystem::path path;
+    std::chrono::nanoseconds interval;
+    std::filesystem::file_time_type last_write;
+    std::chrono::steady_clock::time_point last_check;
+};
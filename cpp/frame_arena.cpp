@@ -0,0 +1,42 @@
+#include "./frame_arena.hpp"
+#include <algorithm>
+#include <cstdint>
+
+static uintptr_t align_up(uintptr_t address, size_t alignment) {
+    return (address + alignment - 1) & ~(uintptr_t)(alignment - 1);
+}
+
+FrameArena::FrameArena(size_t capacity)
+    : block(new byte[max(capacity, (size_t)1)]),
+      block_size(max(capacity, (size_t)1)) {
+}
+
+void *FrameArena::allocate(size_t size, size_t alignment) {
+    auto base = (uintptr_t)block.get();
+    auto start = align_up(base + offset, alignment);
+    if (start - base + size <= block_size) {
+        offset = start - base + size;
+        peak_bytes = max(peak_bytes, used());
+        return (void *)start;
+    }
+
+    /* Out of space, this frame's remaining data goes to the heap */
+    spill_blocks.emplace_back(new byte[size + alignment]);
+    spilled += size;
+    peak_bytes = max(peak_bytes, used());
+    return (void *)align_up((uintptr_t)spill_blocks.back().get(), alignment);
+}
+
+void FrameArena::reset() {
+    if (!spill_blocks.empty()) {
+        overflow_count++;
+        auto needed = used();
+        while (block_size < needed) {
+            block_size *= 2;
+        }
+        block.reset(new byte[block_size]);
+        spill_blocks.clear();
+        spilled = 0;
+    }
+    offset = 0;
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+using namespace std;
+
+/*
+ * Bump allocator for data that lives for one frame. Everything is freed at
+ * once by reset(), individual deallocations are no-ops. A frame that runs out
+ * of space spills into heap blocks, and the next reset grows the arena to
+ * hold that frame, so a steady frame loop stops touching the heap.
+ */
+class FrameArena {
+  public:
+    explicit FrameArena(size_t capacity = 64 * 1024);
+
+    FrameArena(const FrameArena &) = delete;
+    FrameArena &operator=(const FrameArena &) = delete;
+
+    void *allocate(size_t size, size_t alignment);
+    void reset();
+
+    size_t used() const {
+        return offset + spilled;
+    }
+    size_t capacity() const {
+        return block_size;
+    }
+    size_t peak() const {
+        return peak_bytes;
+    }
+    /* Frames that spilled since construction */
+    size_t overflows() const {
+        return overflow_count;
+    }
+
+  private:
+    unique_ptr<byte[]> block;
+    size_t block_size;
+    size_t offset = 0;
+    vector<unique_ptr<byte[]>> spill_blocks;
+    size_t spilled = 0;
+    size_t peak_bytes = 0;
+    size_t overflow_count = 0;
+};
+
+/* Adapts a FrameArena for standard containers */
+template <typename T>
+class ArenaAllocator {
+  public:
+    using value_type = T;
+
+    ArenaAllocator(FrameArena &arena) : arena(&arena) {
+    }
+    template <typename U>
+    ArenaAllocator(const ArenaAllocator<U> &other) : arena(other.arena) {
+    }
+
+    T *allocate(size_t count) {
+        return static_cast<T *>(arena->allocate(count * sizeof(T), alignof(T))
+        );
+    }
+    void deallocate(T *, size_t) {
+    }
+
+    template <typename U>
+    bool operator==(const ArenaAllocator<U> &other) const {
+        return arena == other.arena;
+    }
+
+  private:
+    template <typename U>
+    friend class ArenaAllocator;
+
+    FrameArena *arena;
+};
+
+/* Must not outlive the frame, see FrameArena::reset */
+template <typename T>
+using FrameVector = vector<T, ArenaAllocator<T>>;
@@ -0,0 +1,111 @@
+#include "./frame_pacer.hpp"
+#include "./extension.hpp"
+#include <algorithm>
+#include <cmath>
+#include <thread>
+
+constexpr auto MIN_SPIN = chrono::nanoseconds(chrono::microseconds(200));
+constexpr auto MAX_SPIN = chrono::nanoseconds(chrono::microseconds(4000));
+constexpr auto MIN_BACKOFF = chrono::nanoseconds(chrono::milliseconds(1));
+constexpr auto MAX_BACKOFF = chrono::nanoseconds(chrono::milliseconds(64));
+
+WGPUPresentMode choose_present_mode(
+    const WGPUSurfaceCapabilities &capabilities, WGPUPresentMode preferred
+) {
+    for (size_t i = 0; i < capabilities.presentModeCount; i++) {
+        if (capabilities.presentModes[i] == preferred) {
+            return preferred;
+        }
+    }
+    return WGPUPresentMode_Fifo;
+}
+
+FramePacer::FramePacer(double target_fps)
+    : period(
+          target_fps > 0 && isfinite(target_fps)
+              ? chrono::nanoseconds((int64_t)(1e9 / max(target_fps, 1e-3)))
+              : chrono::nanoseconds(0)
+      ),
+      deadline(Clock::now()), last_frame(Clock::now()) {
+}
+
+void FramePacer::wait() {
+    if (period.count()) {
+        deadline += period;
+        if (Clock::now() > deadline + period) {
+            /* A whole frame behind, resync rather than burst to catch up */
+            deadline = Clock::now();
+        } else {
+            auto oversleep = sleep_until_precise(deadline, spin);
+            spin = clamp(
+                max(spin - spin / 16, oversleep + oversleep / 2),
+                MIN_SPIN,
+                MAX_SPIN
+            );
+        }
+    }
+
+    auto now = Clock::now();
+    if (!resumed) {
+        intervals_ns[count % intervals_ns.size()] = (now - last_frame).count();
+        count++;
+    }
+    resumed = false;
+    last_frame = now;
+}
+
+void FramePacer::resume() {
+    deadline = Clock::now() - period;
+    resumed = true;
+}
+
+void FramePacer::backoff() {
+    backoff_delay = clamp(backoff_delay * 2, MIN_BACKOFF, MAX_BACKOFF);
+    this_thread::sleep_for(backoff_delay);
+}
+
+void FramePacer::reset_backoff() {
+    backoff_delay = chrono::nanoseconds(0);
+}
+
+JitterReport FramePacer::report(FrameArena &arena) const {
+    auto size = min(count, intervals_ns.size());
+    if (size == 0) {
+        return {};
+    }
+
+    double sum = 0;
+    double sum_squares = 0;
+    for (size_t i = 0; i < size; i++) {
+        sum += intervals_ns[i];
+        sum_squares += (double)intervals_ns[i] * intervals_ns[i];
+    }
+    auto mean = sum / size;
+    auto variance = max(0.0, sum_squares / size - mean * mean);
+
+    /* Without a target, jitter is measured against the mean interval */
+    auto target = period.count() ? (double)period.count() : mean;
+    auto errors = FrameVector<double>(size, arena);
+    size_t missed = 0;
+    for (size_t i = 0; i < size; i++) {
+        errors[i] = abs(intervals_ns[i] - target);
+        if (intervals_ns[i] > target * 1.5) {
+            missed++;
+        }
+    }
+    sort(errors.begin(), errors.end());
+
+    return {
+        .frames = count,
+        .target_ms = target / 1e6,
+        .mean_ms = mean / 1e6,
+        .stddev_ms = sqrt(variance) / 1e6,
+        .p99_error_ms = errors[min(size - 1, (size_t)(0.99 * size))] / 1e6,
+        .max_error_ms = errors.back() / 1e6,
+        .missed = missed,
+    };
+}
+
+void FramePacer::reset() {
+    count = 0;
+}
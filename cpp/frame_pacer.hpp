@@ -0,0 +1,62 @@
+#pragma once
+
+#include "./frame_arena.hpp"
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <webgpu/webgpu.h>
+
+using namespace std;
+
+/* Returns `preferred` when the surface supports it, otherwise Fifo */
+WGPUPresentMode choose_present_mode(
+    const WGPUSurfaceCapabilities &capabilities, WGPUPresentMode preferred
+);
+
+struct JitterReport {
+    size_t frames;
+    double target_ms;
+    double mean_ms;
+    double stddev_ms;
+    double p99_error_ms;
+    double max_error_ms;
+    size_t missed;
+};
+
+/*
+ * Frame limiter using a hybrid sleep-then-spin wait. The spin window adapts
+ * to the observed oversleep of the OS timer.
+ */
+class FramePacer {
+  public:
+    using Clock = chrono::steady_clock;
+
+    /* `target_fps` of 0 disables limiting but still measures intervals */
+    explicit FramePacer(double target_fps = 0);
+
+    /* Blocks until the next frame deadline and records the interval */
+    void wait();
+
+    /* Restarts pacing after an idle period without counting the gap */
+    void resume();
+
+    /* Short exponential backoff for when no surface texture is available */
+    void backoff();
+    void reset_backoff();
+
+    /* Sorts a copy of the intervals on `arena` */
+    JitterReport report(FrameArena &arena) const;
+    void reset();
+
+  private:
+    chrono::nanoseconds period;
+    Clock::time_point deadline;
+    Clock::time_point last_frame;
+    chrono::nanoseconds spin = chrono::microseconds(2000);
+    chrono::nanoseconds backoff_delay = chrono::nanoseconds(0);
+    bool resumed = false;
+
+    array<int64_t, 1024> intervals_ns;
+    size_t count = 0;
+};
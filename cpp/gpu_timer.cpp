@@ -0,0 +1,108 @@
+#include "./gpu_timer.hpp"
+#include "./log.hpp"
+#include <algorithm>
+#include <cstring>
+#include <magic_enum/magic_enum.hpp>
+
+/* Beginning and end of the pass */
+constexpr uint32_t QUERY_COUNT = 2;
+constexpr uint64_t QUERY_BYTES = QUERY_COUNT * sizeof(uint64_t);
+
+GpuTimer::GpuTimer(WGPUDevice device, MemoryTracker &memory)
+    : memory(memory) {
+    WGPUQuerySetDescriptor query_set_desc = {
+        .label = "pass_timestamps",
+        .type = WGPUQueryType_Timestamp,
+        .count = QUERY_COUNT,
+    };
+    query_set = wgpuDeviceCreateQuerySet(device, &query_set_desc);
+
+    WGPUBufferDescriptor resolve_desc = {
+        .nextInChain = nullptr,
+        .label = "timestamp_resolve",
+        .usage = WGPUBufferUsage_QueryResolve | WGPUBufferUsage_CopySrc,
+        .size = QUERY_BYTES,
+        .mappedAtCreation = false,
+    };
+    resolve_buffer =
+        memory.create_buffer(device, resolve_desc, MemoryCategory::Queries);
+
+    WGPUBufferDescriptor readback_desc = {
+        .nextInChain = nullptr,
+        .label = "timestamp_readback",
+        .usage = WGPUBufferUsage_MapRead | WGPUBufferUsage_CopyDst,
+        .size = QUERY_BYTES,
+        .mappedAtCreation = false,
+    };
+    readback_buffer =
+        memory.create_buffer(device, readback_desc, MemoryCategory::Queries);
+
+    writes = {
+        .querySet = query_set,
+        .beginningOfPassWriteIndex = 0,
+        .endOfPassWriteIndex = 1,
+    };
+}
+
+GpuTimer::~GpuTimer() {
+    memory.release_buffer(readback_buffer);
+    memory.release_buffer(resolve_buffer);
+    wgpuQuerySetRelease(query_set);
+}
+
+const WGPURenderPassTimestampWrites *GpuTimer::begin_pass() {
+    if (state != State::Idle) {
+        return nullptr;
+    }
+    state = State::Writing;
+    return &writes;
+}
+
+void GpuTimer::end_pass(WGPUCommandEncoder encoder) {
+    if (state != State::Writing) {
+        return;
+    }
+    wgpuCommandEncoderResolveQuerySet(
+        encoder, query_set, 0, QUERY_COUNT, resolve_buffer, 0
+    );
+    wgpuCommandEncoderCopyBufferToBuffer(
+        encoder, resolve_buffer, 0, readback_buffer, 0, QUERY_BYTES
+    );
+    state = State::Resolved;
+}
+
+void GpuTimer::submitted() {
+    if (state != State::Resolved) {
+        return;
+    }
+    state = State::Mapping;
+    wgpuBufferMapAsync(
+        readback_buffer, WGPUMapMode_Read, 0, QUERY_BYTES, on_mapped, this
+    );
+}
+
+void GpuTimer::on_mapped(WGPUBufferMapAsyncStatus status, void *user_data) {
+    auto timer = static_cast<GpuTimer *>(user_data);
+    timer->state = State::Idle;
+    if (status != WGPUBufferMapAsyncStatus_Success) {
+        LOG_WARN("timestamp readback: {}", magic_enum::enum_name(status));
+        return;
+    }
+    uint64_t timestamps[QUERY_COUNT];
+    memcpy(
+        timestamps,
+        wgpuBufferGetConstMappedRange(timer->readback_buffer, 0, QUERY_BYTES),
+        QUERY_BYTES
+    );
+    wgpuBufferUnmap(timer->readback_buffer);
+
+    /* Timestamps are nanoseconds, a reset counter can make them go back */
+    if (timestamps[1] < timestamps[0]) {
+        return;
+    }
+    auto pass_ns = timestamps[1] - timestamps[0];
+    auto &stats = timer->time_stats;
+    stats.frames++;
+    stats.total_ns += pass_ns;
+    stats.max_ns = max(stats.max_ns, pass_ns);
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include "./memory_tracker.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <webgpu/webgpu.h>
+
+using namespace std;
+
+struct GpuTimeStats {
+    size_t frames;
+    uint64_t total_ns;
+    uint64_t max_ns;
+};
+
+/*
+ * Times one render pass on the GPU with timestamp queries, for devices with
+ * the TimestampQuery feature. The timestamps are copied to a readback buffer
+ * and mapped asynchronously, the map completing during a later submit.
+ * Frames recorded while a readback is in flight are not timed, so timing
+ * never waits on the GPU.
+ */
+class GpuTimer {
+  public:
+    GpuTimer(WGPUDevice device, MemoryTracker &memory);
+    ~GpuTimer();
+
+    GpuTimer(const GpuTimer &) = delete;
+    GpuTimer &operator=(const GpuTimer &) = delete;
+
+    /* Timestamp writes for the pass descriptor, nullptr when not timed */
+    const WGPURenderPassTimestampWrites *begin_pass();
+    /* Resolves the timestamps of a timed pass, after the pass ended */
+    void end_pass(WGPUCommandEncoder encoder);
+    /* Starts reading back the timestamps, after the pass was submitted */
+    void submitted();
+
+    /* Passes read back since the last reset */
+    const GpuTimeStats &stats() const {
+        return time_stats;
+    }
+    void reset() {
+        time_stats = {};
+    }
+
+  private:
+    enum class State : uint8_t {
+        Idle,
+        Writing,
+        Resolved,
+        Mapping,
+    };
+
+    static void on_mapped(WGPUBufferMapAsyncStatus status, void *user_data);
+
+    MemoryTracker &memory;
+    WGPUQuerySet query_set;
+    WGPUBuffer resolve_buffer;
+    WGPUBuffer readback_buffer;
+    WGPURenderPassTimestampWrites writes;
+    State state = State::Idle;
+    GpuTimeStats time_stats = {};
+};
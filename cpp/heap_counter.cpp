@@ -0,0 +1,26 @@
+#include "./heap_counter.hpp"
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+static atomic<uint64_t> allocation_count = 0;
+
+uint64_t heap_allocations() {
+    return allocation_count.load(memory_order_relaxed);
+}
+
+void *operator new(size_t size) {
+    allocation_count.fetch_add(1, memory_order_relaxed);
+    if (auto memory = malloc(size ? size : 1)) {
+        return memory;
+    }
+    throw bad_alloc();
+}
+
+void operator delete(void *memory) noexcept {
+    free(memory);
+}
+
+void operator delete(void *memory, size_t) noexcept {
+    free(memory);
+}
@@ -0,0 +1,13 @@
+#pragma once
+
+#include <cstdint>
+
+using namespace std;
+
+/*
+ * Count of global operator new calls on any thread since startup. Linking
+ * heap_counter.cpp replaces the global operator new and delete; over-aligned
+ * allocations and memory allocated outside C++, e.g. by wgpu, are not
+ * counted.
+ */
+uint64_t heap_allocations();
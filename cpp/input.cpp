@@ -0,0 +1,84 @@
+#include "./input.hpp"
+#include <algorithm>
+#include <chrono>
+
+int64_t now_ns() {
+    auto since_epoch = chrono::steady_clock::now().time_since_epoch();
+    return chrono::duration_cast<chrono::nanoseconds>(since_epoch).count();
+}
+
+static InputQueue *window_queue(GLFWwindow *window) {
+    return static_cast<InputQueue *>(glfwGetWindowUserPointer(window));
+}
+
+void install_input_callbacks(GLFWwindow *window, InputQueue *queue) {
+    glfwSetWindowUserPointer(window, queue);
+
+    glfwSetKeyCallback(
+        window,
+        [](GLFWwindow *window, int key, int, int action, int mods) {
+            window_queue(window)->push({
+                .type = InputType::Key,
+                .code = key,
+                .action = action,
+                .mods = mods,
+                .timestamp_ns = now_ns(),
+            });
+        }
+    );
+    glfwSetMouseButtonCallback(
+        window,
+        [](GLFWwindow *window, int button, int action, int mods) {
+            double x_pos;
+            double y_pos;
+            glfwGetCursorPos(window, &x_pos, &y_pos);
+            window_queue(window)->push({
+                .type = InputType::MouseButton,
+                .code = button,
+                .action = action,
+                .mods = mods,
+                .x = x_pos,
+                .y = y_pos,
+                .timestamp_ns = now_ns(),
+            });
+        }
+    );
+    glfwSetWindowCloseCallback(window, [](GLFWwindow *window) {
+        window_queue(window)->push({
+            .type = InputType::WindowClose,
+            .timestamp_ns = now_ns(),
+        });
+    });
+}
+
+void LatencyTracker::record(int64_t latency_ns) {
+    samples[count % samples.size()] = latency_ns;
+    count++;
+}
+
+LatencyReport LatencyTracker::report(FrameArena &arena) const {
+    auto size = min(count, samples.size());
+    if (size == 0) {
+        return {};
+    }
+
+    auto sorted = FrameVector<int64_t>(
+        samples.begin(), samples.begin() + size, arena
+    );
+    sort(sorted.begin(), sorted.end());
+    auto percentile_ms = [&](double p) {
+        auto index = min(size - 1, (size_t)(p * size));
+        return sorted[index] / 1e6;
+    };
+    return {
+        .count = count,
+        .p50_ms = percentile_ms(0.50),
+        .p90_ms = percentile_ms(0.90),
+        .p99_ms = percentile_ms(0.99),
+        .max_ms = sorted.back() / 1e6,
+    };
+}
+
+void LatencyTracker::reset() {
+    count = 0;
+}
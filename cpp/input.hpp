@@ -0,0 +1,64 @@
+#pragma once
+
+#include "./frame_arena.hpp"
+#include "./ring.hpp"
+#include <GLFW/glfw3.h>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+using namespace std;
+
+enum class InputType : uint8_t {
+    Key,
+    MouseButton,
+    WindowClose,
+};
+
+struct InputEvent {
+    InputType type;
+    int32_t code;
+    int32_t action;
+    int32_t mods;
+    double x;
+    double y;
+    int64_t timestamp_ns;
+};
+
+struct InputQueue {
+    SpscRing<InputEvent, 1024> events;
+    atomic<uint32_t> dropped = 0;
+
+    void push(const InputEvent &event) {
+        if (!events.push(event)) {
+            dropped.fetch_add(1, memory_order_relaxed);
+        }
+    }
+};
+
+int64_t now_ns();
+
+/* Routes key, mouse button and close callbacks of `window` into `queue` */
+void install_input_callbacks(GLFWwindow *window, InputQueue *queue);
+
+struct LatencyReport {
+    size_t count;
+    double p50_ms;
+    double p90_ms;
+    double p99_ms;
+    double max_ms;
+};
+
+/* Keeps the most recent input-to-present latencies */
+class LatencyTracker {
+  public:
+    void record(int64_t latency_ns);
+    /* Sorts a copy of the samples on `arena` */
+    LatencyReport report(FrameArena &arena) const;
+    void reset();
+
+  private:
+    array<int64_t, 4096> samples;
+    size_t count = 0;
+};
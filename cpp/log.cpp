@@ -0,0 +1,181 @@
+#include "./log.hpp"
+#include "./ring.hpp"
+#include <chrono>
+#include <cstdio>
+#include <thread>
+
+constexpr size_t LOG_RING_SIZE = 1024;
+constexpr int64_t LOG_SITE_WINDOW_NS = 1'000'000'000;
+constexpr auto MAX_IDLE_SLEEP = chrono::milliseconds(32);
+
+static const int64_t start_ns = log_clock_ns();
+
+static constexpr string_view level_name(LogLevel level) {
+    switch (level) {
+    case LogLevel::Debug:
+        return "debug";
+    case LogLevel::Info:
+        return "info";
+    case LogLevel::Warn:
+        return "warn";
+    case LogLevel::Error:
+        return "error";
+    }
+    return "";
+}
+
+class Logger {
+  public:
+    Logger() : writer([this] { run(); }) {
+    }
+
+    ~Logger() {
+        running.store(false, memory_order_release);
+        writer.join();
+    }
+
+    void push(const LogRecord &record) {
+        pushed.fetch_add(1, memory_order_relaxed);
+        if (!ring.push(record)) {
+            dropped.fetch_add(1, memory_order_relaxed);
+            written.fetch_add(1, memory_order_release);
+        }
+    }
+
+    void flush() {
+        auto target = pushed.load(memory_order_acquire);
+        while (written.load(memory_order_acquire) < target) {
+            this_thread::yield();
+        }
+    }
+
+    void write_now(
+        LogLevel level,
+        int64_t timestamp_ns,
+        uint32_t suppressed,
+        string_view message
+    ) {
+        flush();
+        auto line = string();
+        begin_line(line, level, timestamp_ns);
+        line.append(message);
+        write_line(line, level, suppressed);
+        fflush(level >= LogLevel::Warn ? stderr : stdout);
+    }
+
+  private:
+    void run() {
+        auto line = string();
+        auto idle_sleep = chrono::milliseconds(1);
+        while (true) {
+            auto wrote = drain(line);
+            if (!wrote) {
+                if (!running.load(memory_order_acquire)) {
+                    drain(line);
+                    return;
+                }
+                this_thread::sleep_for(idle_sleep);
+                idle_sleep = min(idle_sleep * 2, MAX_IDLE_SLEEP);
+            } else {
+                idle_sleep = chrono::milliseconds(1);
+            }
+        }
+    }
+
+    static void begin_line(string &line, LogLevel level, int64_t timestamp_ns) {
+        line.clear();
+        format_to(
+            back_inserter(line),
+            "[{:.6f}] {}: ",
+            (timestamp_ns - start_ns) / 1e9,
+            level_name(level)
+        );
+    }
+
+    static void write_line(string &line, LogLevel level, uint32_t suppressed) {
+        if (suppressed) {
+            format_to(
+                back_inserter(line),
+                " ({} similar messages suppressed)",
+                suppressed
+            );
+        }
+        line.push_back('\n');
+
+        auto out = level >= LogLevel::Warn ? stderr : stdout;
+        fwrite(line.data(), 1, line.size(), out);
+    }
+
+    bool drain(string &line) {
+        auto wrote = false;
+        LogRecord record;
+        while (ring.pop(record)) {
+            begin_line(line, record.level, record.timestamp_ns);
+            record.formatter(record, line);
+            write_line(line, record.level, record.suppressed);
+            written.fetch_add(1, memory_order_release);
+            wrote = true;
+        }
+
+        auto lost = dropped.exchange(0, memory_order_relaxed);
+        if (lost) {
+            fprintf(stderr, "log ring full, dropped %u messages\n", lost);
+        }
+        if (wrote) {
+            fflush(stdout);
+            fflush(stderr);
+        }
+        return wrote;
+    }
+
+    MpscRing<LogRecord, LOG_RING_SIZE> ring;
+    atomic<uint64_t> pushed = 0;
+    atomic<uint64_t> written = 0;
+    atomic<uint32_t> dropped = 0;
+    atomic<bool> running = true;
+    thread writer;
+};
+
+static Logger &logger() {
+    static Logger instance;
+    return instance;
+}
+
+int64_t log_clock_ns() {
+    auto since_epoch = chrono::steady_clock::now().time_since_epoch();
+    return chrono::duration_cast<chrono::nanoseconds>(since_epoch).count();
+}
+
+void log_push(const LogRecord &record) {
+    logger().push(record);
+}
+
+void log_flush() {
+    logger().flush();
+}
+
+void log_write_now(
+    LogLevel level,
+    int64_t timestamp_ns,
+    uint32_t suppressed,
+    string_view message
+) {
+    logger().write_now(level, timestamp_ns, suppressed, message);
+}
+
+bool LogSite::allow(int64_t now_ns, uint32_t &reported_suppressed) {
+    auto window_start = window_start_ns.load(memory_order_relaxed);
+    if (now_ns - window_start > LOG_SITE_WINDOW_NS &&
+        window_start_ns.compare_exchange_strong(
+            window_start, now_ns, memory_order_relaxed
+        )) {
+        count.store(0, memory_order_relaxed);
+    }
+
+    if (count.fetch_add(1, memory_order_relaxed) >= limit) {
+        suppressed.fetch_add(1, memory_order_relaxed);
+        return false;
+    }
+    reported_suppressed = suppressed.exchange(0, memory_order_relaxed);
+    return true;
+}
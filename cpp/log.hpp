@@ -0,0 +1,233 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <format>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+
+using namespace std;
+
+enum class LogLevel : uint8_t {
+    Debug,
+    Info,
+    Warn,
+    Error,
+};
+
+/* Calls below this level compile to nothing, override with -DLOG_LEVEL=n */
+#ifndef LOG_LEVEL
+#define LOG_LEVEL 1
+#endif
+
+constexpr size_t LOG_PAYLOAD_SIZE = 512;
+constexpr uint32_t LOG_SITE_LIMIT = 20;
+
+/* Arguments are captured by value and formatted on the writer thread */
+struct LogRecord {
+    using Formatter = void (*)(const LogRecord &, string &);
+
+    Formatter formatter;
+    string_view format;
+    int64_t timestamp_ns;
+    uint32_t suppressed;
+    LogLevel level;
+    byte payload[LOG_PAYLOAD_SIZE];
+};
+
+/* Per call site rate limit, at most `limit` messages per second */
+struct LogSite {
+    uint32_t limit = LOG_SITE_LIMIT;
+    atomic<int64_t> window_start_ns = 0;
+    atomic<uint32_t> count = 0;
+    atomic<uint32_t> suppressed = 0;
+
+    bool allow(int64_t now_ns, uint32_t &reported_suppressed);
+};
+
+int64_t log_clock_ns();
+void log_push(const LogRecord &record);
+
+/*
+ * Strings are copied into the payload as a 16-bit length and their bytes,
+ * sharing whatever space the fixed-size arguments leave. Everything else
+ * must be trivially copyable and is stored as-is.
+ */
+template <typename T>
+constexpr bool log_is_string = is_convertible_v<const T &, string_view>;
+
+template <typename T>
+using log_captured_t = conditional_t<log_is_string<T>, string_view, T>;
+
+template <typename T>
+constexpr size_t log_fixed_size() {
+    if constexpr (log_is_string<T>) {
+        return sizeof(uint16_t);
+    } else {
+        static_assert(
+            is_trivially_copyable_v<T>, "log arguments must be copyable"
+        );
+        return sizeof(T);
+    }
+}
+
+/* Ends a string cut short to fit the payload */
+constexpr string_view LOG_TRUNCATED = "...[truncated]";
+
+template <typename T>
+string_view log_string(const T &value) {
+    if constexpr (is_pointer_v<T>) {
+        return value ? string_view(value) : string_view("(null)");
+    } else {
+        return value;
+    }
+}
+
+template <typename T>
+size_t log_string_size(const T &value) {
+    if constexpr (log_is_string<T>) {
+        return log_string(value).size();
+    } else {
+        return 0;
+    }
+}
+
+template <typename T>
+log_captured_t<T> log_capture(const T &value) {
+    if constexpr (log_is_string<T>) {
+        return log_string(value);
+    } else {
+        return value;
+    }
+}
+
+template <typename T>
+void log_store(byte *&cursor, size_t &string_budget, const T &value) {
+    if constexpr (log_is_string<T>) {
+        auto view = log_string(value);
+        auto length = (uint16_t)min(view.size(), string_budget);
+        auto marker = string_view();
+        if (view.size() > string_budget) {
+            marker = LOG_TRUNCATED.substr(
+                0, min(LOG_TRUNCATED.size(), string_budget)
+            );
+            length = (uint16_t)(string_budget - marker.size());
+        }
+        auto stored = (uint16_t)(length + marker.size());
+        string_budget -= stored;
+        memcpy(cursor, &stored, sizeof(stored));
+        memcpy(cursor + sizeof(stored), view.data(), length);
+        memcpy(cursor + sizeof(stored) + length, marker.data(), marker.size());
+        cursor += sizeof(stored) + stored;
+    } else {
+        memcpy(cursor, &value, sizeof(T));
+        cursor += sizeof(T);
+    }
+}
+
+/* Flushes queued records, then writes `message` from the calling thread */
+void log_write_now(
+    LogLevel level,
+    int64_t timestamp_ns,
+    uint32_t suppressed,
+    string_view message
+);
+
+template <typename T>
+T log_load(const byte *&cursor) {
+    if constexpr (is_same_v<T, string_view>) {
+        uint16_t length;
+        memcpy(&length, cursor, sizeof(length));
+        auto view = string_view((const char *)cursor + sizeof(length), length);
+        cursor += sizeof(length) + length;
+        return view;
+    } else {
+        T value;
+        memcpy(&value, cursor, sizeof(T));
+        cursor += sizeof(T);
+        return value;
+    }
+}
+
+template <typename... Captured>
+void log_format(const LogRecord &record, string &out) {
+    [[maybe_unused]] auto cursor = (const byte *)record.payload;
+    /* Braced initialisation keeps the loads in argument order */
+    auto args = tuple<Captured...>{log_load<Captured>(cursor)...};
+    apply(
+        [&](auto &...arg) {
+            vformat_to(
+                back_inserter(out), record.format, make_format_args(arg...)
+            );
+        },
+        args
+    );
+}
+
+template <typename... Args>
+void log_write(
+    LogLevel level, LogSite &site, format_string<Args...> format, Args &&...args
+) {
+    auto timestamp_ns = log_clock_ns();
+    uint32_t suppressed = 0;
+    if (!site.allow(timestamp_ns, suppressed)) {
+        return;
+    }
+
+    constexpr size_t fixed_size =
+        (log_fixed_size<remove_cvref_t<Args>>() + ... + 0);
+    static_assert(fixed_size <= LOG_PAYLOAD_SIZE, "log arguments too large");
+
+    [[maybe_unused]] auto string_budget = LOG_PAYLOAD_SIZE - fixed_size;
+    [[maybe_unused]] auto string_size =
+        (log_string_size(args) + ... + size_t(0));
+    /* Warnings and errors too long for a record are written in full */
+    if (level >= LogLevel::Warn && string_size > string_budget) {
+        auto captured = tuple<log_captured_t<remove_cvref_t<Args>>...>{
+            log_capture(args)...
+        };
+        auto message = apply(
+            [&](auto &...arg) {
+                return vformat(format.get(), make_format_args(arg...));
+            },
+            captured
+        );
+        log_write_now(level, timestamp_ns, suppressed, message);
+        return;
+    }
+
+    LogRecord record;
+    record.formatter = log_format<log_captured_t<remove_cvref_t<Args>>...>;
+    record.format = format.get();
+    record.timestamp_ns = timestamp_ns;
+    record.suppressed = suppressed;
+    record.level = level;
+
+    [[maybe_unused]] auto cursor = record.payload;
+    (log_store(cursor, string_budget, args), ...);
+    log_push(record);
+}
+
+/* Blocks until every record pushed so far has been written */
+void log_flush();
+
+#define LOG_AT_SITE(level, site_limit, ...)                                    \
+    do {                                                                       \
+        if constexpr ((int)(level) >= LOG_LEVEL) {                             \
+            static LogSite log_site{.limit = site_limit};                      \
+            log_write(level, log_site, __VA_ARGS__);                           \
+        }                                                                      \
+    } while (0)
+#define LOG_AT(level, ...) LOG_AT_SITE(level, LOG_SITE_LIMIT, __VA_ARGS__)
+/* For reports that loop over their lines, which must all be written */
+#define LOG_UNLIMITED(level, ...) LOG_AT_SITE(level, UINT32_MAX, __VA_ARGS__)
+
+#define LOG_DEBUG(...) LOG_AT(LogLevel::Debug, __VA_ARGS__)
+#define LOG_INFO(...) LOG_AT(LogLevel::Info, __VA_ARGS__)
+#define LOG_WARN(...) LOG_AT(LogLevel::Warn, __VA_ARGS__)
+#define LOG_ERROR(...) LOG_AT(LogLevel::Error, __VA_ARGS__)
@@ -1,15 +1,32 @@
+#include "./backend.hpp"
+#include "./batcher.hpp"
+#include "./capabilities.hpp"
+#include "./capture.hpp"
+#include "./encoding.hpp"
+#include "./extension.hpp"
 #include "./glfw_wgpu.hpp"
+#include "./frame_arena.hpp"
+#include "./frame_pacer.hpp"
+#include "./gpu_timer.hpp"
+#include "./heap_counter.hpp"
+#include "./input.hpp"
+#include "./log.hpp"
+#include "./memory_tracker.hpp"
+#include "./options.hpp"
+#include "./pipeline.hpp"
+#include "./scene_file.hpp"
 #include "./shape.hpp"
+#include "./simulation.hpp"
+#include "./uniform_batches.hpp"
 #include <GLFW/glfw3.h>
-#include <chrono>
 #include <cmath>
 #include <cstdio>
 #include <format>
 #include <fstream>
 #include <magic_enum/magic_enum.hpp>
-#include <print>
+#include <numbers>
+#include <optional>
 #include <sstream>
-#include <thread>
 #include <vector>
 #include <webgpu/webgpu.h>
 
@@ -19,12 +36,6 @@ constexpr size_t SCREEN_WIDTH = 600;
 constexpr size_t SCREEN_HEIGHT = 600;
 constexpr size_t GRID_WIDTH = 4;
 constexpr size_t GRID_HEIGHT = 4;
-constexpr size_t SQUARE_COUNT = GRID_WIDTH * GRID_HEIGHT;
-
-struct UniformData {
-    array<Mat4, SQUARE_COUNT> model_transformations;
-    array<Vec4, SQUARE_COUNT> model_colors;
-};
 
 WGPUAdapter get_adapter(WGPUInstance instance, WGPUSurface surface) {
     WGPUAdapter adapter = nullptr;
@@ -42,7 +53,12 @@ WGPUAdapter get_adapter(WGPUInstance instance, WGPUSurface surface) {
     return adapter;
 }
 
-WGPUDevice get_device(WGPUAdapter adapter) {
+/* Requests everything the adapter allows instead of the default limits */
+WGPUDevice get_device(
+    WGPUAdapter adapter,
+    const WGPULimits &limits,
+    span<const WGPUFeatureName> features
+) {
     WGPUDevice device = nullptr;
     auto callback = [](WGPURequestDeviceStatus status,
                        WGPUDevice device,
@@ -50,23 +66,27 @@ WGPUDevice get_device(WGPUAdapter adapter) {
                        WGPU_NULLABLE void *user_data_v) {
         if (status !=
             WGPURequestDeviceStatus::WGPURequestDeviceStatus_Success) {
-            println(stderr, "failed getting device");
+            LOG_ERROR("failed getting device");
         }
         WGPUDevice *const user_data = static_cast<WGPUDevice *>(user_data_v);
         *user_data = device;
     };
 
+    auto required_limits = WGPURequiredLimits{.limits = limits};
     auto descriptor = WGPUDeviceDescriptor{
         .label = "device_1",
+        .requiredFeatureCount = features.size(),
+        .requiredFeatures = features.data(),
+        .requiredLimits = &required_limits,
         .defaultQueue = {.label = "queue_1"},
         .deviceLostCallback =
             [](WGPUDeviceLostReason reason, char const *message, void *) {
-                println(
+                LOG_ERROR(
                     "Uncaptured device error: type {}",
                     magic_enum::enum_name(reason)
                 );
                 if (message) {
-                    println("{}", message);
+                    LOG_ERROR("{}", message);
                 }
             },
     };
@@ -74,10 +94,165 @@ WGPUDevice get_device(WGPUAdapter adapter) {
     return device;
 }
 
-int main() {
+constexpr int64_t REPORT_INTERVAL_NS = 5'000'000'000;
+constexpr double IDLE_WAIT_SECONDS = 0.25;
+constexpr char SHADER_PATH[] = "shader.wgsl";
+
+/* Maps `path`, or builds the default grid when it is empty */
+SceneView load_scene(
+    const string &path, SceneData &builtin, optional<SceneFile> &file
+) {
+    if (!path.empty()) {
+        return file.emplace(path).view();
+    }
+    builtin = grid_scene(GRID_WIDTH, GRID_HEIGHT);
+    return builtin.view();
+}
+
+/* Returns the grid cell under a left click */
+optional<size_t> handle_click(const InputEvent &event) {
+    if (event.code != GLFW_MOUSE_BUTTON_1 || event.action != GLFW_PRESS) {
+        return nullopt;
+    }
+
+    constexpr float SEGMENT_WIDTH = (float)SCREEN_WIDTH / GRID_WIDTH;
+    constexpr float SEGMENT_HEIGHT = (float)SCREEN_HEIGHT / GRID_HEIGHT;
+
+    size_t x_seg = event.x / SEGMENT_WIDTH;
+    size_t y_seg = event.y / SEGMENT_HEIGHT;
+
+    float x_wgsl = (event.x / (SCREEN_WIDTH / 2.0)) - 1;
+    float y_wgsl = 1 - (event.y / (SCREEN_HEIGHT / 2.0));
+    LOG_INFO(
+        "clicked: [{}, {}], [{}, {}], [{}, {}]",
+        event.x,
+        event.y,
+        x_seg,
+        y_seg,
+        x_wgsl,
+        y_wgsl
+    );
+    if (x_seg >= GRID_WIDTH || y_seg >= GRID_HEIGHT) {
+        return nullopt;
+    }
+    return y_seg * GRID_WIDTH + x_seg;
+}
+
+void print_latency(
+    const LatencyTracker &latency, InputQueue &input_queue, FrameArena &arena
+) {
+    auto report = latency.report(arena);
+    if (!report.count) {
+        return;
+    }
+    LOG_INFO(
+        "input to present: p50 {:.2f}ms, p90 {:.2f}ms, p99 {:.2f}ms, "
+        "max {:.2f}ms ({} events, {} dropped)",
+        report.p50_ms,
+        report.p90_ms,
+        report.p99_ms,
+        report.max_ms,
+        report.count,
+        input_queue.dropped.load()
+    );
+}
+
+void print_batches(const BatchStats &stats) {
+    LOG_INFO(
+        "quad batches: {} quads in {} draws, {} state flushes, "
+        "{} capacity flushes, {} bytes, capacity {}",
+        stats.quads,
+        stats.draws,
+        stats.state_flushes,
+        stats.capacity_flushes,
+        stats.bytes,
+        stats.capacity
+    );
+}
+
+struct EncodeStats {
+    size_t frames;
+    int64_t total_ns;
+    int64_t max_ns;
+};
+
+void print_gpu_time(const GpuTimeStats &stats) {
+    if (!stats.frames) {
+        return;
+    }
+    LOG_INFO(
+        "gpu scene pass: mean {:.1f}us, max {:.1f}us over {} frames",
+        stats.total_ns / 1e3 / stats.frames,
+        stats.max_ns / 1e3,
+        stats.frames
+    );
+}
+
+void print_encode(const EncodeStats &stats, const SceneBundle &bundle) {
+    if (!stats.frames) {
+        return;
+    }
+    LOG_INFO(
+        "encode: mean {:.1f}us, max {:.1f}us, {} bundle recordings",
+        stats.total_ns / 1e3 / stats.frames,
+        stats.max_ns / 1e3,
+        bundle.recorded()
+    );
+}
+
+struct AllocationStats {
+    size_t frames;
+    size_t allocating_frames;
+    uint64_t allocations;
+};
+
+void print_allocations(const AllocationStats &stats, const FrameArena &arena) {
+    if (!stats.frames) {
+        return;
+    }
+    LOG_INFO(
+        "heap: {} allocations in {} of {} frames, frame arena peak {} of {} "
+        "bytes, {} overflows",
+        stats.allocations,
+        stats.allocating_frames,
+        stats.frames,
+        arena.peak(),
+        arena.capacity(),
+        arena.overflows()
+    );
+}
+
+void print_jitter(const FramePacer &pacer, FrameArena &arena) {
+    auto report = pacer.report(arena);
+    if (!report.frames) {
+        return;
+    }
+    LOG_INFO(
+        "frame pacing: target {:.3f}ms, mean {:.3f}ms, stddev {:.3f}ms, "
+        "p99 error {:.3f}ms, max error {:.3f}ms, {} missed",
+        report.target_ms,
+        report.mean_ms,
+        report.stddev_ms,
+        report.p99_error_ms,
+        report.max_error_ms,
+        report.missed
+    );
+}
+
+int main(int argc, char **argv) {
     try {
         /* Init */
-        println("starting");
+        auto options = parse_options(argc, argv);
+        auto builtin_scene = SceneData();
+        auto scene_file = optional<SceneFile>();
+
+        if (!options.replay_path.empty()) {
+            auto reader = CaptureReader(options.replay_path);
+            auto scene =
+                load_scene(reader.scene_path(), builtin_scene, scene_file);
+            return replay_capture(reader, scene) ? 1 : 0;
+        }
+        LOG_INFO("starting");
 
 #ifdef WINDOWS
 // @todo: catches null refs but messes up try/catch
@@ -93,20 +268,20 @@ int main() {
         int32_t minor;
         int32_t rev;
         glfwGetVersion(&major, &minor, &rev);
-        println("glfw v{}.{}.{}", major, minor, rev);
+        LOG_INFO("glfw v{}.{}.{}", major, minor, rev);
 
         auto x11_support = glfwPlatformSupported(GLFW_PLATFORM_X11);
         auto wayland_support = glfwPlatformSupported(GLFW_PLATFORM_WAYLAND);
         auto windows_support = glfwPlatformSupported(GLFW_PLATFORM_WIN32);
-        println("x11     support: {}", (bool)x11_support);
-        println("wayland support: {}", (bool)wayland_support);
-        println("windows support: {}", (bool)windows_support);
+        LOG_INFO("x11     support: {}", (bool)x11_support);
+        LOG_INFO("wayland support: {}", (bool)wayland_support);
+        LOG_INFO("windows support: {}", (bool)windows_support);
 
         auto platform = glfwGetPlatform();
         if (platform == GLFW_PLATFORM_WAYLAND) {
-            println("Using Wayland backend");
+            LOG_INFO("Using Wayland backend");
         } else if (platform == GLFW_PLATFORM_X11) {
-            println("Using X11 backend");
+            LOG_INFO("Using X11 backend");
         }
 
         glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
@@ -121,112 +296,92 @@ int main() {
 #endif
 
         glfwSetErrorCallback([](int error_code, const char *description) {
-            println(stderr, "glfw err {}, {}", error_code, description);
+            LOG_ERROR("glfw err {}, {}", error_code, description);
         });
         auto window = glfwCreateWindow(
             SCREEN_WIDTH, SCREEN_HEIGHT, "Block", nullptr, nullptr
         );
         if (!window) {
-            println("window failed to open properly");
+            LOG_ERROR("window failed to open properly");
             return 1;
         }
 
         glfwSetWindowAttrib(window, GLFW_FOCUS_ON_SHOW, GLFW_FALSE);
 
-        glfwSetWindowCloseCallback(window, [](GLFWwindow *) {
-            println("window close event detected");
-        });
-        glfwSetMouseButtonCallback(
-            window,
-            [](GLFWwindow *window, int button, int action, int) {
-                if (button != GLFW_MOUSE_BUTTON_1 || action != GLFW_PRESS) {
-                    return;
-                }
-
-                double x_pos;
-                double y_pos;
-                glfwGetCursorPos(window, &x_pos, &y_pos);
-
-                constexpr float SEGMENT_WIDTH =
-                    (float)SCREEN_WIDTH / GRID_WIDTH;
-                constexpr float SEGMENT_HEIGHT =
-                    (float)SCREEN_HEIGHT / GRID_HEIGHT;
-
-                size_t x_seg = x_pos / SEGMENT_WIDTH;
-                size_t y_seg = y_pos / SEGMENT_HEIGHT;
-
-                float x_wgsl = (x_pos / (SCREEN_WIDTH / 2.0)) - 1;
-                float y_wgsl = 1 - (y_pos / (SCREEN_HEIGHT / 2.0));
-                println(
-                    "clicked: [{}, {}], [{}, {}], [{}, {}]",
-                    x_pos,
-                    y_pos,
-                    x_seg,
-                    y_seg,
-                    x_wgsl,
-                    y_wgsl
-                );
-            }
-        );
+        auto input_queue = InputQueue();
+        install_input_callbacks(window, &input_queue);
 
         auto instance = wgpuCreateInstance(nullptr);
         if (!instance) {
-            println(stderr, "expected instance");
+            LOG_ERROR("expected instance");
             return 1;
         }
 
-        println("getting surface...");
+        LOG_INFO("getting surface...");
         auto surface = glfwCreateWindowWGPUSurface(instance, window);
-        println("getting surface...done");
+        LOG_INFO("getting surface...done");
 
-        println("getting adapter...");
+        LOG_INFO("getting adapter...");
         auto adapter = get_adapter(instance, surface);
-        println("getting adapter...done");
+        LOG_INFO("getting adapter...done");
         if (!adapter) {
-            println(stderr, "expected adapter");
+            LOG_ERROR("expected adapter");
             return 1;
         }
         wgpuInstanceRelease(instance);
 
         size_t adapter_feature_count =
             wgpuAdapterEnumerateFeatures(adapter, nullptr);
-        println("adapter features: {}", adapter_feature_count);
+        LOG_INFO("adapter features: {}", adapter_feature_count);
         auto adapter_features = vector<WGPUFeatureName>(adapter_feature_count);
         wgpuAdapterEnumerateFeatures(adapter, adapter_features.data());
 
         WGPUAdapterInfo adapter_info = {};
         wgpuAdapterGetInfo(adapter, &adapter_info);
-        println(
+        LOG_INFO(
             "{}, {}, {}",
             adapter_info.device,
             magic_enum::enum_name(adapter_info.backendType),
             magic_enum::enum_name(adapter_info.adapterType)
         );
 
-        auto device = get_device(adapter);
+        WGPUSupportedLimits adapter_limits = {};
+        wgpuAdapterGetLimits(adapter, &adapter_limits);
+        auto strategy =
+            select_strategy(adapter_limits.limits, adapter_features);
+        log_strategy(strategy);
+        if (!strategy.max_batch_instances) {
+            throw runtime_error("device has no room for instance data");
+        }
+        auto uniform = strategy.instance_data == InstanceData::Uniform;
+
+        auto device = get_device(
+            adapter, adapter_limits.limits, strategy.required_features
+        );
         if (!device) {
-            println(stderr, "expected device");
+            LOG_ERROR("expected device");
             return 1;
         }
 
-        println("getting features...");
+        LOG_INFO("getting features...");
         size_t device_feature_count =
             wgpuDeviceEnumerateFeatures(device, nullptr);
-        println("device features: {}", device_feature_count);
+        LOG_INFO("device features: {}", device_feature_count);
         auto device_features = vector<WGPUFeatureName>(device_feature_count);
         wgpuDeviceEnumerateFeatures(device, device_features.data());
-        println("getting features...done");
+        LOG_INFO("getting features...done");
 
-        println("getting limits...");
+        LOG_INFO("getting limits...");
         WGPUSupportedLimits limits = {};
         wgpuDeviceGetLimits(device, &limits);
-        println("getting limits...done");
+        LOG_INFO("getting limits...done");
+        auto memory = MemoryTracker(limits.limits);
 
         auto queue = wgpuDeviceGetQueue(device);
         wgpuQueueOnSubmittedWorkDone(
             queue,
             [](WGPUQueueWorkDoneStatus status, WGPU_NULLABLE void *) {
-                println("queued work done {}", magic_enum::enum_name(status));
+                LOG_INFO("queued work done {}", magic_enum::enum_name(status));
             },
             nullptr
         );
@@ -234,6 +389,9 @@ int main() {
         WGPUSurfaceCapabilities capabilities = {};
         wgpuSurfaceGetCapabilities(surface, adapter, &capabilities);
         auto texture_format = capabilities.formats[0];
+        auto present_mode =
+            choose_present_mode(capabilities, options.present_mode);
+        LOG_INFO("present mode: {}", magic_enum::enum_name(present_mode));
         WGPUSurfaceConfiguration surface_config = {
             .device = device,
             .format = texture_format,
@@ -241,285 +399,432 @@ int main() {
             .alphaMode = WGPUCompositeAlphaMode_Auto,
             .width = SCREEN_WIDTH,
             .height = SCREEN_HEIGHT,
-            .presentMode = WGPUPresentMode_Fifo,
+            .presentMode = present_mode,
         };
 
         wgpuAdapterRelease(adapter);
         wgpuSurfaceConfigure(surface, &surface_config);
 
-        auto file = ifstream("shader.wgsl");
-        if (!file.is_open()) {
-            throw runtime_error("shader not found");
-        }
-        auto buffer = stringstream();
-        buffer << file.rdbuf();
-        auto shader_code = buffer.str();
+        auto shader_code = read_shader(SHADER_PATH);
 
-        WGPUShaderModuleWGSLDescriptor shader_code_desc = {
-            .chain =
-                {
-                    .sType = WGPUSType_ShaderModuleWGSLDescriptor,
-                },
-            .code = shader_code.data(),
-        };
-        auto shader_descriptor = WGPUShaderModuleDescriptor{
-            .nextInChain = &shader_code_desc.chain,
-        };
-        auto shader_module =
-            wgpuDeviceCreateShaderModule(device, &shader_descriptor);
+        /** Render pipeline */
 
-        WGPUBlendState blend_state = {
-            .color =
-                {
-                    .operation = WGPUBlendOperation_Add,
-                    .srcFactor = WGPUBlendFactor_SrcAlpha,
-                    .dstFactor = WGPUBlendFactor_OneMinusSrcAlpha,
-                },
-            .alpha =
-                {
-                    .operation = WGPUBlendOperation_Add,
-                    .srcFactor = WGPUBlendFactor_Zero,
-                    .dstFactor = WGPUBlendFactor_One,
-                },
-        };
-        WGPUColorTargetState color_target = {
-            .format = texture_format,
-            .blend = &blend_state,
-            .writeMask = WGPUColorWriteMask_All,
-        };
-        WGPUFragmentState fragment_state{
-            .module = shader_module,
-            .entryPoint = "fs_main",
-            .targetCount = 1,
-            .targets = &color_target,
+        auto instance_layout =
+            create_instance_bind_group_layout(device, strategy);
+        WGPUPipelineLayoutDescriptor pipeline_layout_desc = {
+            .label = "scene_pipeline_layout",
+            .bindGroupLayoutCount = 1,
+            .bindGroupLayouts = &instance_layout,
         };
+        auto pipeline_layout =
+            wgpuDeviceCreatePipelineLayout(device, &pipeline_layout_desc);
+        auto pipelines = Pipelines();
+        if (!create_pipelines(
+                device,
+                texture_format,
+                shader_code,
+                pipeline_layout,
+                strategy,
+                pipelines
+            )) {
+            throw runtime_error("failed creating render pipelines");
+        }
 
-        WGPUVertexAttribute vertex_attributes[] = {
-            {
-                .format = WGPUVertexFormat_Float32x4,
-                .offset = 0,
-                .shaderLocation = 0,
-            },
-            {
-                .format = WGPUVertexFormat_Float32x4,
-                .offset = 16,
-                .shaderLocation = 1,
-            },
-        };
+        /** Depth */
 
-        WGPUVertexBufferLayout vertex_buffer_layout = {
-            .arrayStride = sizeof(Vertex),
-            .stepMode = WGPUVertexStepMode_Vertex,
-            .attributeCount =
-                sizeof(vertex_attributes) / sizeof(WGPUVertexAttribute),
-            .attributes = vertex_attributes,
-        };
-        WGPURenderPipelineDescriptor pipeline_desc = {
-            .vertex =
-                {
-                    .module = shader_module,
-                    .entryPoint = "vs_main",
-                    .bufferCount = 1,
-                    .buffers = &vertex_buffer_layout,
-                },
-            .primitive =
-                {
-                    .topology = WGPUPrimitiveTopology_TriangleList,
-                    .stripIndexFormat = WGPUIndexFormat_Undefined,
-                    .frontFace = WGPUFrontFace_CCW,
-                    .cullMode = WGPUCullMode_None,
-                },
-            .multisample =
-                {
-                    .count = 1,
-                    .mask = ~0u,
-                    .alphaToCoverageEnabled = false,
-                },
-            .fragment = &fragment_state,
+        WGPUTextureDescriptor depth_texture_desc = {
+            .label = "depth_texture",
+            .usage = WGPUTextureUsage_RenderAttachment,
+            .dimension = WGPUTextureDimension_2D,
+            .size = {SCREEN_WIDTH, SCREEN_HEIGHT, 1},
+            .format = DEPTH_FORMAT,
+            .mipLevelCount = 1,
+            .sampleCount = 1,
+            .viewFormatCount = 0,
+            .viewFormats = nullptr,
         };
+        auto depth_texture = memory.create_texture(
+            device, depth_texture_desc, MemoryCategory::Attachments
+        );
+        auto depth_view = wgpuTextureCreateView(depth_texture, nullptr);
 
-        /** Render pipeline */
+        /** Scene */
 
-        auto render_pipeline =
-            wgpuDeviceCreateRenderPipeline(device, &pipeline_desc);
+        auto scene =
+            load_scene(options.scene_path, builtin_scene, scene_file);
+        LOG_INFO(
+            "scene: {} meshes, {} vertices, {} instances",
+            scene.meshes.size(),
+            scene.vertices.size(),
+            scene.transforms.size()
+        );
+        if (scene.vertices.empty() || !scene.drawn_instances()) {
+            throw runtime_error("scene has nothing to draw");
+        }
+        memory.set_host(
+            "scene",
+            scene.meshes.size_bytes() + scene.vertices.size_bytes() +
+                scene.transforms.size_bytes() + scene.colors.size_bytes()
+        );
+        /* Uniform batches split the scene, storage binds it whole */
+        if (!uniform &&
+            scene.transforms.size() > strategy.max_batch_instances) {
+            throw runtime_error(format(
+                "scene has {} instances, device allows {}",
+                scene.transforms.size(),
+                strategy.max_batch_instances
+            ));
+        }
 
         /** Vertex data */
 
-        auto triangle_data = vector{
-            SquareModel(),
-        };
-        auto triangle_buffer_size =
-            triangle_data.size() * sizeof(decltype(triangle_data)::value_type);
         WGPUBufferDescriptor vertex_buffer_desc = {
             .nextInChain = nullptr,
             .label = "vertex_buffer",
             .usage = WGPUBufferUsage_CopyDst | WGPUBufferUsage_Vertex,
-            .size = triangle_buffer_size,
+            .size = scene.vertices.size_bytes(),
             .mappedAtCreation = false,
         };
-        auto vertex_buffer =
-            wgpuDeviceCreateBuffer(device, &vertex_buffer_desc);
-        wgpuQueueWriteBuffer(
-            queue, vertex_buffer, 0, triangle_data.data(), triangle_buffer_size
+        auto vertex_buffer = memory.create_buffer(
+            device, vertex_buffer_desc, MemoryCategory::Geometry
         );
 
-        /** Uniform data */
-
-        constexpr float WGSL_WIDTH = 2.0 / GRID_WIDTH;
-        constexpr float WGSL_HEIGHT = 2.0 / GRID_HEIGHT;
-        constexpr float TEMP_TRANSLATE_X = GRID_WIDTH / 2.0 - 1;
-        constexpr float TEMP_TRANSLATE_Y = GRID_HEIGHT / 2.0 - 1;
-        auto grid_origin_matrix =
-            scale_mat4(mat4(), {WGSL_WIDTH, WGSL_HEIGHT, 1.0});
-        grid_origin_matrix = translate_mat4(
-            grid_origin_matrix,
-            {-WGSL_WIDTH * TEMP_TRANSLATE_X, WGSL_HEIGHT * TEMP_TRANSLATE_Y, 0.0
-            }
-        );
+        /** Instance data */
+
+        WGPUBuffer transform_buffer = nullptr;
+        WGPUBuffer color_buffer = nullptr;
+        WGPUBuffer order_buffer = nullptr;
+        WGPUBuffer batch_buffer = nullptr;
+        WGPUBindGroup instance_bind_group = nullptr;
+        auto batches = optional<UniformBatches>();
+        auto storage_backend = optional<WgpuBackend>();
+        auto uniform_backend = optional<WgpuUniformBackend>();
+        /* Uploads come straight from the scene, which may be the mapped file */
+        if (uniform) {
+            batches.emplace(
+                scene.transforms,
+                scene.colors,
+                scene.drawn_instances(),
+                strategy.max_batch_instances,
+                strategy.buffer_alignment
+            );
+            WGPUBufferDescriptor batch_buffer_desc = {
+                .nextInChain = nullptr,
+                .label = "batch_buffer",
+                .usage = WGPUBufferUsage_CopyDst | WGPUBufferUsage_Uniform,
+                .size = batches->buffer_size(),
+                .mappedAtCreation = false,
+            };
+            batch_buffer = memory.create_buffer(
+                device, batch_buffer_desc, MemoryCategory::Instances
+            );
+            memory.set_host("uniform_batches", batches->buffer_size());
+
+            WGPUBindGroupEntry batch_entry = {
+                .binding = 3,
+                .buffer = batch_buffer,
+                .offset = 0,
+                .size = UniformBatches::batch_size(batches->batch_instances()),
+            };
+            WGPUBindGroupDescriptor batch_bind_group_descriptor = {
+                .label = "instance_batch_bind_group",
+                .layout = instance_layout,
+                .entryCount = 1,
+                .entries = &batch_entry,
+            };
+            instance_bind_group =
+                wgpuDeviceCreateBindGroup(device, &batch_bind_group_descriptor);
+            uniform_backend.emplace(
+                queue,
+                vertex_buffer,
+                batch_buffer,
+                instance_bind_group,
+                *batches
+            );
+        } else {
+            WGPUBufferDescriptor transform_buffer_desc = {
+                .nextInChain = nullptr,
+                .label = "transform_buffer",
+                .usage = WGPUBufferUsage_CopyDst | WGPUBufferUsage_Storage,
+                .size = scene.transforms.size_bytes(),
+                .mappedAtCreation = false,
+            };
+            transform_buffer = memory.create_buffer(
+                device, transform_buffer_desc, MemoryCategory::Instances
+            );
+
+            WGPUBufferDescriptor color_buffer_desc = {
+                .nextInChain = nullptr,
+                .label = "color_buffer",
+                .usage = WGPUBufferUsage_CopyDst | WGPUBufferUsage_Storage,
+                .size = scene.colors.size_bytes(),
+                .mappedAtCreation = false,
+            };
+            color_buffer = memory.create_buffer(
+                device, color_buffer_desc, MemoryCategory::Instances
+            );
+
+            auto order_size = scene.drawn_instances() * sizeof(uint32_t);
+            WGPUBufferDescriptor order_buffer_desc = {
+                .nextInChain = nullptr,
+                .label = "order_buffer",
+                .usage = WGPUBufferUsage_CopyDst | WGPUBufferUsage_Storage,
+                .size = order_size,
+                .mappedAtCreation = false,
+            };
+            order_buffer = memory.create_buffer(
+                device, order_buffer_desc, MemoryCategory::Instances
+            );
+
+            WGPUBindGroupEntry bind_group_entries[] = {
+                {
+                    .binding = 0,
+                    .buffer = transform_buffer,
+                    .offset = 0,
+                    .size = scene.transforms.size_bytes(),
+                },
+                {
+                    .binding = 1,
+                    .buffer = color_buffer,
+                    .offset = 0,
+                    .size = scene.colors.size_bytes(),
+                },
+                {
+                    .binding = 2,
+                    .buffer = order_buffer,
+                    .offset = 0,
+                    .size = order_size,
+                },
+            };
+            /* The explicit layout keeps it valid across pipeline reloads */
+            WGPUBindGroupDescriptor instance_bind_group_descriptor = {
+                .label = "instance_bind_group",
+                .layout = instance_layout,
+                .entryCount =
+                    sizeof(bind_group_entries) / sizeof(WGPUBindGroupEntry),
+                .entries = bind_group_entries,
+            };
+            instance_bind_group = wgpuDeviceCreateBindGroup(
+                device, &instance_bind_group_descriptor
+            );
 
-        auto matrix_data = array<Mat4, SQUARE_COUNT>();
-        for (size_t j = 0; j < GRID_WIDTH; j++) {
-            for (size_t i = 0; i < GRID_HEIGHT; i++) {
-                auto model_matrix = translate_mat4(
-                    grid_origin_matrix, {WGSL_WIDTH * i, -WGSL_HEIGHT * j, 0.0}
+            storage_backend.emplace(
+                queue,
+                array{
+                    vertex_buffer, transform_buffer, color_buffer, order_buffer
+                }
+            );
+        }
+        WgpuBackend &wgpu_backend =
+            uniform ? *uniform_backend : *storage_backend;
+        wgpu_backend.set_pipelines(pipelines.scene);
+        auto capture = optional<CaptureBackend>();
+        FrameBackend *backend = &wgpu_backend;
+        if (!options.capture_path.empty()) {
+            backend = &capture.emplace(
+                options.capture_path, options.scene_path, wgpu_backend
+            );
+            LOG_INFO("capturing to {}", options.capture_path);
+        }
+        auto simulation = Simulation(scene);
+        auto batcher = QuadBatcher(device, queue, memory);
+        auto gpu_timer = optional<GpuTimer>();
+        if (strategy.timestamp_queries) {
+            gpu_timer.emplace(device, memory);
+        }
+        auto cell_transforms = grid_transforms(GRID_WIDTH, GRID_HEIGHT);
+        auto highlighted = optional<size_t>();
+        auto batch_stats = BatchStats();
+
+        /* Scene draws only change with the draw order, so they are bundled */
+        auto scene_bundle =
+            SceneBundle(device, texture_format, DEPTH_FORMAT);
+        auto record_scene = RecordBundle([&](WGPURenderBundleEncoder bundle) {
+            wgpuRenderBundleEncoderSetVertexBuffer(
+                bundle, 0, vertex_buffer, 0, scene.vertices.size_bytes()
+            );
+            /* The uniform backend binds each batch as it draws */
+            if (!uniform) {
+                wgpuRenderBundleEncoderSetBindGroup(
+                    bundle, 0, instance_bind_group, 0, nullptr
                 );
-                matrix_data[j * GRID_WIDTH + i] = model_matrix;
             }
-        }
-
-        UniformData uniform_data = {
-            .model_transformations = matrix_data,
-            .model_colors = {{
-                {1.0, 0.0, 0.0, 1},
-                {0.0, 1.0, 0.0, 1},
-                {0.0, 0.0, 1.0, 1},
-                {0.0, 0.0, 0.0, 0},
-                {0.0, 0.0, 0.0, 0},
-                {0.0, 0.0, 0.0, 0},
-                {0.0, 0.0, 0.0, 0},
-                {0.0, 0.0, 0.0, 0},
-                {0.0, 0.0, 0.0, 0},
-                {0.0, 0.0, 0.0, 0},
-                {0.0, 0.0, 0.0, 0},
-                {0.0, 0.0, 0.0, 0},
-                {0.0, 0.0, 0.0, 0},
-                {0.0, 0.0, 0.0, 0},
-                {0.0, 0.0, 0.0, 0},
-                {0.0, 0.0, 0.0, 0},
-            }},
-        };
+            wgpu_backend.set_bundle_encoder(bundle);
+            simulation.draw(wgpu_backend);
+            wgpu_backend.set_bundle_encoder(nullptr);
+        });
 
-        WGPUBufferDescriptor uniform_buffer_desc = {
-            .nextInChain = nullptr,
-            .label = "uniform_buffer",
-            .usage = WGPUBufferUsage_CopyDst | WGPUBufferUsage_Uniform,
-            .size = sizeof(UniformData),
-            .mappedAtCreation = false,
-        };
-        auto uniform_buffer =
-            wgpuDeviceCreateBuffer(device, &uniform_buffer_desc);
-        WGPUBindGroupEntry bind_group_entry = {
-            .binding = 0,
-            .buffer = uniform_buffer,
-            .offset = 0,
-            .size = sizeof(UniformData),
+        /* Recorded in parallel, submitted scene first */
+        WGPUTextureView frame_view = nullptr;
+        WGPURenderBundle frame_bundle = nullptr;
+        auto scene_pass = [&](WGPUCommandEncoder command_encoder) {
+            WGPURenderPassColorAttachment color_attachment = {
+                .view = frame_view,
+                .resolveTarget = nullptr,
+                .loadOp = WGPULoadOp_Clear,
+                .storeOp = WGPUStoreOp_Store,
+                .clearValue = WGPUColor{0.0, 0.0, 0.0, 1.0},
+            };
+            WGPURenderPassDepthStencilAttachment depth_attachment = {
+                .view = depth_view,
+                .depthLoadOp = WGPULoadOp_Clear,
+                .depthStoreOp = WGPUStoreOp_Store,
+                .depthClearValue = 1.0,
+                .depthReadOnly = false,
+                .stencilLoadOp = WGPULoadOp_Undefined,
+                .stencilStoreOp = WGPUStoreOp_Undefined,
+                .stencilClearValue = 0,
+                .stencilReadOnly = false,
+            };
+            auto timestamp_writes =
+                gpu_timer ? gpu_timer->begin_pass() : nullptr;
+            WGPURenderPassDescriptor pass_desc = {
+                .colorAttachmentCount = 1,
+                .colorAttachments = &color_attachment,
+                .depthStencilAttachment = &depth_attachment,
+                .timestampWrites = timestamp_writes,
+            };
+            auto render_pass =
+                wgpuCommandEncoderBeginRenderPass(command_encoder, &pass_desc);
+            wgpuRenderPassEncoderExecuteBundles(render_pass, 1, &frame_bundle);
+            wgpuRenderPassEncoderEnd(render_pass);
+            wgpuRenderPassEncoderRelease(render_pass);
+            if (gpu_timer) {
+                gpu_timer->end_pass(command_encoder);
+            }
         };
-        WGPUBindGroupDescriptor uniform_bind_group_descriptor = {
-            .label = "uniform_bind_group",
-            .layout = wgpuRenderPipelineGetBindGroupLayout(render_pipeline, 0),
-            .entryCount = 1,
-            .entries = &bind_group_entry,
+        auto overlay_pass = [&](WGPUCommandEncoder command_encoder) {
+            WGPURenderPassColorAttachment color_attachment = {
+                .view = frame_view,
+                .resolveTarget = nullptr,
+                .loadOp = WGPULoadOp_Load,
+                .storeOp = WGPUStoreOp_Store,
+            };
+            WGPURenderPassDepthStencilAttachment depth_attachment = {
+                .view = depth_view,
+                .depthLoadOp = WGPULoadOp_Load,
+                .depthStoreOp = WGPUStoreOp_Discard,
+                .depthClearValue = 1.0,
+                .depthReadOnly = false,
+                .stencilLoadOp = WGPULoadOp_Undefined,
+                .stencilStoreOp = WGPUStoreOp_Undefined,
+                .stencilClearValue = 0,
+                .stencilReadOnly = false,
+            };
+            WGPURenderPassDescriptor pass_desc = {
+                .colorAttachmentCount = 1,
+                .colorAttachments = &color_attachment,
+                .depthStencilAttachment = &depth_attachment,
+                .timestampWrites = nullptr,
+            };
+            auto render_pass =
+                wgpuCommandEncoderBeginRenderPass(command_encoder, &pass_desc);
+            batcher.begin(render_pass);
+            batcher.set_pipeline(pipelines.quad);
+            if (highlighted) {
+                batcher.draw_quad(
+                    cell_transforms[*highlighted], {1.0, 1.0, 1.0, 0.35}
+                );
+            }
+            batch_stats = batcher.end();
+            wgpuRenderPassEncoderEnd(render_pass);
+            wgpuRenderPassEncoderRelease(render_pass);
         };
-        auto uniform_bind_group =
-            wgpuDeviceCreateBindGroup(device, &uniform_bind_group_descriptor);
+        auto passes = array<RecordPass, 2>{scene_pass, overlay_pass};
+        auto encoder = ParallelEncoder(device, queue);
+        auto encode_stats = EncodeStats();
+
+        auto shader_watcher =
+            FileWatcher(SHADER_PATH, chrono::milliseconds(250));
+
+        LOG_INFO("running...");
+        auto latency = LatencyTracker();
+        auto pacer = FramePacer(options.target_fps);
+        auto last_report_ns = now_ns();
+        /* Oldest input not yet presented, 0 when none */
+        int64_t pending_input_ns = 0;
+        auto scene_dirty = true;
+        auto arena = FrameArena();
+        auto allocation_stats = AllocationStats();
+        while (!glfwWindowShouldClose(window)) {
+            if (options.on_demand && !scene_dirty) {
+                glfwWaitEventsTimeout(IDLE_WAIT_SECONDS);
+                pacer.resume();
+            } else {
+                pacer.wait();
+                glfwPollEvents();
+            }
 
-        wgpuQueueWriteBuffer(
-            queue, uniform_buffer, 0, &uniform_data, sizeof(UniformData)
-        );
+            arena.reset();
+            auto frame_start_allocations = heap_allocations();
+            auto now = (float)glfwGetTime();
+            auto frame_events = FrameVector<InputEvent>(arena);
+            /* Input that changes the frame, measured until it is presented */
+            auto consume = [&](const InputEvent &event) {
+                if (!pending_input_ns) {
+                    pending_input_ns = event.timestamp_ns;
+                }
+                scene_dirty = true;
+            };
+            InputEvent event;
+            while (input_queue.events.pop(event)) {
+                frame_events.push_back(event);
+                switch (event.type) {
+                case InputType::Key:
+                    if (event.code == GLFW_KEY_M &&
+                        event.action == GLFW_PRESS) {
+                        memory.report(true);
+                    }
+                    if (event.action == GLFW_PRESS &&
+                        Simulation::handles_key(event.code)) {
+                        consume(event);
+                    }
+                    break;
+                case InputType::MouseButton:
+                    if (auto cell = handle_click(event)) {
+                        highlighted = cell == highlighted ? nullopt : cell;
+                        consume(event);
+                    }
+                    break;
+                case InputType::WindowClose:
+                    LOG_INFO("window close event detected");
+                    break;
+                }
+            }
 
-        println("running...");
-        // bool key_release = false;
-        // auto w_key_release = optional(false);
-        // optional<bool> w_key_release = nullopt;
-        while (!glfwWindowShouldClose(window)) {
-            glfwPollEvents();
-
-            // if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS) {
-            //     model1_matrix = scale_mat4(model1_matrix, {0.95, 0.95, 1});
-            //     uniform_data = {
-            //         .model_matrix =
-            //             {
-            //                 model1_matrix,
-            //                 // model2_matrix,
-            //             },
-            //     };
-            //     wgpuQueueWriteBuffer(
-            //         queue, uniform_buffer, 0, &uniform_data,
-            //         sizeof(UniformData)
-            //     );
-            // }
-            // if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS) {
-            //     model1_matrix = scale_mat4(model1_matrix, {1.05, 1.05, 1});
-            //     uniform_data = {
-            //         .model_matrix =
-            //             {
-            //                 model1_matrix,
-            //                 // model2_matrix,
-            //             },
-            //     };
-            //     wgpuQueueWriteBuffer(
-            //         queue, uniform_buffer, 0, &uniform_data,
-            //         sizeof(UniformData)
-            //     );
-            // }
-            // if (!w_key_release.has_value() &&
-            //     glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS) {
-            //     w_key_release = optional(false);
-            // }
-            // if (w_key_release.has_value() && !w_key_release.value() &&
-            //     glfwGetKey(window, GLFW_KEY_W) == GLFW_RELEASE) {
-            //     w_key_release = optional(true);
-            // }
-            // if (w_key_release.has_value() && w_key_release.value()) {
-            //     w_key_release = nullopt;
-            //     println("release");
-            //     constexpr float ROTATION = numbers::pi / 20;
-            //     auto cosx = cos(ROTATION);
-            //     auto siny = sin(ROTATION);
-            //     model1_matrix = rotate_mat4(model1_matrix, {cosx, siny});
-            //     uniform_data = {
-            //         .model_matrix =
-            //             {
-            //                 model1_matrix,
-            //                 // model2_matrix,
-            //             },
-            //     };
-            //     wgpuQueueWriteBuffer(
-            //         queue, uniform_buffer, 0, &uniform_data,
-            //         sizeof(UniformData)
-            //     );
-            // }
+            if (shader_watcher.changed()) {
+                auto code = try_read_shader(SHADER_PATH);
+                auto reloaded = Pipelines();
+                if (!code) {
+                    LOG_WARN("shader unreadable, keeping the previous one");
+                    shader_watcher.rearm();
+                } else if (create_pipelines(
+                               device,
+                               texture_format,
+                               *code,
+                               pipeline_layout,
+                               strategy,
+                               reloaded
+                           )) {
+                    release_pipelines(pipelines);
+                    pipelines = reloaded;
+                    wgpu_backend.set_pipelines(pipelines.scene);
+                    scene_bundle.invalidate();
+                    LOG_INFO("shader reloaded");
+                    scene_dirty = true;
+                }
+            }
+
+            if (capture) {
+                capture->begin_frame(now, frame_events);
+            }
+            if (simulation.update(now, frame_events, *backend)) {
+                scene_dirty = true;
+            }
+            if (options.on_demand && !scene_dirty) {
+                continue;
+            }
 
-            // if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS) {
-            //     // if (!tick) {
-            //     tick = true;
-            //     constexpr float ROTATION = numbers::pi / 2;
-            //     auto cosx = cos(ROTATION);
-            //     auto siny = sin(ROTATION);
-            //     model1_matrix = rotate_mat4(model1_matrix, {cosx, siny});
-            //     uniform_data = {
-            //         .model_matrix =
-            //             {
-            //                 model1_matrix,
-            //                 model2_matrix,
-            //             },
-            //     };
-            //     wgpuQueueWriteBuffer(
-            //         queue, uniform_buffer, 0, &uniform_data,
-            //         sizeof(UniformData)
-            //     );
-            //     // }
-            // }
             // if (glfwGetKey(window, GLFW_KEY_SPACE) == GLFW_PRESS) {
             //     println("space");
             //     triangle_data[0].translate({0.0, 0.0, -0.01});
@@ -546,9 +851,10 @@ int main() {
             WGPUSurfaceTexture surface_texture = {};
             wgpuSurfaceGetCurrentTexture(surface, &surface_texture);
             if (!surface_texture.texture) {
-                std::this_thread::sleep_for(chrono::seconds(1));
+                pacer.backoff();
                 continue;
             }
+            pacer.reset_backoff();
 
             WGPUTextureViewDescriptor texture_view_desc = {
                 .nextInChain = nullptr,
@@ -570,68 +876,87 @@ int main() {
             wgpuTextureRelease(surface_texture.texture);
 #endif
 
-            WGPURenderPassColorAttachment renderPassColorAttachment = {
-                .view = texture_view,
-                .resolveTarget = nullptr,
-                .loadOp = WGPULoadOp_Clear,
-                .storeOp = WGPUStoreOp_Store,
-                .clearValue = WGPUColor{0.0, 0.0, 0.0, 1.0},
-            };
-            WGPURenderPassDescriptor renderPassDesc = {
-                .colorAttachmentCount = 1,
-                .colorAttachments = &renderPassColorAttachment,
-                .depthStencilAttachment = nullptr,
-                .timestampWrites = nullptr,
-            };
-
-            auto command_encoder =
-                wgpuDeviceCreateCommandEncoder(device, nullptr);
-            auto render_pass = wgpuCommandEncoderBeginRenderPass(
-                command_encoder, &renderPassDesc
-            );
-
-            wgpuRenderPassEncoderSetPipeline(render_pass, render_pipeline);
-            wgpuRenderPassEncoderSetVertexBuffer(
-                render_pass, 0, vertex_buffer, 0, triangle_buffer_size
-            );
-            wgpuRenderPassEncoderSetBindGroup(
-                render_pass, 0, uniform_bind_group, 0, nullptr
-            );
-
-            // auto temp = triangle_data
-            wgpuRenderPassEncoderDraw(
-                // @todo: generic vert count
-                // render_pass, triangle_data.size() * 3, 1, 0, 0
-                render_pass,
-                triangle_data.size() * 6,
-                SQUARE_COUNT,
-                0,
-                0
-            );
-            wgpuRenderPassEncoderEnd(render_pass);
-            wgpuRenderPassEncoderRelease(render_pass);
-
-            auto command_buffer =
-                wgpuCommandEncoderFinish(command_encoder, nullptr);
-            wgpuCommandEncoderRelease(command_encoder);
-
-            wgpuQueueSubmit(queue, 1, &command_buffer);
-            wgpuCommandBufferRelease(command_buffer);
+            frame_view = texture_view;
+            if (capture) {
+                /* The bundle may be older than this frame, capture its draws */
+                simulation.draw(*capture);
+            }
+            auto encode_start_ns = now_ns();
+            frame_bundle =
+                scene_bundle.get(simulation.draw_generation(), record_scene);
+            encoder.submit(passes);
+            if (gpu_timer) {
+                gpu_timer->submitted();
+            }
+            auto encode_ns = now_ns() - encode_start_ns;
+            encode_stats.frames++;
+            encode_stats.total_ns += encode_ns;
+            encode_stats.max_ns = max(encode_stats.max_ns, encode_ns);
 
             wgpuSurfacePresent(surface);
+            auto present_ns = now_ns();
+            if (pending_input_ns) {
+                latency.record(present_ns - pending_input_ns);
+                pending_input_ns = 0;
+            }
+            scene_dirty = simulation.animating();
+            if (present_ns - last_report_ns > REPORT_INTERVAL_NS) {
+                print_latency(latency, input_queue, arena);
+                print_jitter(pacer, arena);
+                print_batches(batch_stats);
+                print_encode(encode_stats, scene_bundle);
+                if (gpu_timer) {
+                    print_gpu_time(gpu_timer->stats());
+                    gpu_timer->reset();
+                }
+                memory.report();
+                print_allocations(allocation_stats, arena);
+                latency.reset();
+                pacer.reset();
+                encode_stats = {};
+                allocation_stats = {};
+                last_report_ns = present_ns;
+            }
 
             wgpuTextureViewRelease(texture_view);
+            /* Includes the report, counted towards the next one */
+            auto frame_allocations =
+                heap_allocations() - frame_start_allocations;
+            allocation_stats.frames++;
+            allocation_stats.allocations += frame_allocations;
+            allocation_stats.allocating_frames += frame_allocations != 0;
         }
 
         /* Cleanup */
 
+        print_latency(latency, input_queue, arena);
+        print_jitter(pacer, arena);
+
+        scene_bundle.invalidate();
+        gpu_timer.reset();
+        wgpuBindGroupRelease(instance_bind_group);
+        release_pipelines(pipelines);
+        wgpuPipelineLayoutRelease(pipeline_layout);
+        wgpuBindGroupLayoutRelease(instance_layout);
+        wgpuTextureViewRelease(depth_view);
+        memory.release_texture(depth_texture);
+        memory.release_buffer(vertex_buffer);
+        for (auto buffer :
+             {transform_buffer, color_buffer, order_buffer, batch_buffer}) {
+            if (buffer) {
+                memory.release_buffer(buffer);
+            }
+        }
+        memory.set_host("uniform_batches", 0);
+        memory.set_host("scene", 0);
+        memory.report(true);
         wgpuQueueRelease(queue);
         wgpuDeviceRelease(device);
         wgpuSurfaceRelease(surface);
         glfwDestroyWindow(window);
         glfwTerminate();
-        println("done");
+        LOG_INFO("done");
     } catch (runtime_error &err) {
-        println("{}", err.what());
+        LOG_ERROR("{}", err.what());
     }
 }
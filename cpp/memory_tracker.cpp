@@ -0,0 +1,259 @@
+#include "./memory_tracker.hpp"
+#include "./log.hpp"
+#include <algorithm>
+#include <magic_enum/magic_enum.hpp>
+
+static void grow(MemoryUsage &usage, size_t bytes) {
+    usage.bytes += bytes;
+    usage.peak_bytes = max(usage.peak_bytes, usage.bytes);
+    usage.live++;
+    usage.created++;
+}
+
+static void shrink(MemoryUsage &usage, size_t bytes) {
+    usage.bytes -= bytes;
+    usage.live--;
+    usage.released++;
+}
+
+/* Every format created here has 4 byte texels */
+static size_t texture_bytes(const WGPUTextureDescriptor &desc) {
+    size_t bytes = 0;
+    size_t width = desc.size.width;
+    size_t height = desc.size.height;
+    for (uint32_t level = 0; level < max(desc.mipLevelCount, 1u); level++) {
+        bytes += width * height * 4;
+        width = max(width / 2, (size_t)1);
+        height = max(height / 2, (size_t)1);
+    }
+    return bytes * desc.size.depthOrArrayLayers * max(desc.sampleCount, 1u);
+}
+
+static string_view label_of(const char *label) {
+    return label ? label : "unlabeled";
+}
+
+MemoryTracker::MemoryTracker(const WGPULimits &limits) : limits(limits) {
+}
+
+MemoryTracker::~MemoryTracker() {
+    report_leaks();
+}
+
+WGPUBuffer MemoryTracker::create_buffer(
+    WGPUDevice device,
+    const WGPUBufferDescriptor &desc,
+    MemoryCategory category
+) {
+    auto label = label_of(desc.label);
+    if (desc.size > limits.maxBufferSize) {
+        LOG_WARN(
+            "buffer {} of {} bytes exceeds max buffer size {}",
+            label,
+            desc.size,
+            limits.maxBufferSize
+        );
+    }
+    auto storage = (desc.usage & WGPUBufferUsage_Storage) != 0;
+    if (storage && desc.size > limits.maxStorageBufferBindingSize) {
+        LOG_WARN(
+            "buffer {} of {} bytes exceeds max storage binding size {}",
+            label,
+            desc.size,
+            limits.maxStorageBufferBindingSize
+        );
+    }
+    if ((desc.usage & WGPUBufferUsage_Uniform) &&
+        desc.size > limits.maxUniformBufferBindingSize) {
+        LOG_WARN(
+            "buffer {} of {} bytes exceeds max uniform binding size {}",
+            label,
+            desc.size,
+            limits.maxUniformBufferBindingSize
+        );
+    }
+
+    auto buffer = wgpuDeviceCreateBuffer(device, &desc);
+    if (buffer) {
+        add(buffer, category, label, desc.size, storage);
+    }
+    return buffer;
+}
+
+void MemoryTracker::release_buffer(WGPUBuffer buffer) {
+    remove(buffer);
+    wgpuBufferRelease(buffer);
+}
+
+WGPUTexture MemoryTracker::create_texture(
+    WGPUDevice device,
+    const WGPUTextureDescriptor &desc,
+    MemoryCategory category
+) {
+    auto label = label_of(desc.label);
+    auto max_dimension = max(desc.size.width, desc.size.height);
+    if (max_dimension > limits.maxTextureDimension2D) {
+        LOG_WARN(
+            "texture {} of {}x{} exceeds max dimension {}",
+            label,
+            desc.size.width,
+            desc.size.height,
+            limits.maxTextureDimension2D
+        );
+    }
+
+    auto texture = wgpuDeviceCreateTexture(device, &desc);
+    if (texture) {
+        add(texture, category, label, texture_bytes(desc), false);
+    }
+    return texture;
+}
+
+void MemoryTracker::release_texture(WGPUTexture texture) {
+    remove(texture);
+    wgpuTextureRelease(texture);
+}
+
+void MemoryTracker::set_host(string_view label, size_t bytes) {
+    auto guard = lock_guard(lock);
+    auto found = host.find(label);
+    if (found == host.end()) {
+        found = host.emplace(label, 0).first;
+    }
+    auto &held = found->second;
+    if (held == bytes) {
+        return;
+    }
+    auto &category = categories[(size_t)MemoryCategory::Host];
+    auto &by_label = find_label(label)->second;
+    if (held) {
+        shrink(category, held);
+        shrink(by_label, held);
+        shrink(totals, held);
+    }
+    if (bytes) {
+        grow(category, bytes);
+        grow(by_label, bytes);
+        grow(totals, bytes);
+    }
+    held = bytes;
+}
+
+map<string, MemoryUsage, less<>>::iterator
+MemoryTracker::find_label(string_view label) {
+    auto found = labels.find(label);
+    if (found == labels.end()) {
+        found = labels.emplace(label, MemoryUsage()).first;
+    }
+    return found;
+}
+
+void MemoryTracker::add(
+    const void *handle,
+    MemoryCategory category,
+    string_view label,
+    size_t bytes,
+    bool storage
+) {
+    auto guard = lock_guard(lock);
+    auto by_label = find_label(label);
+    grow(categories[(size_t)category], bytes);
+    grow(by_label->second, bytes);
+    grow(totals, bytes);
+    allocations.emplace(
+        handle, Allocation{category, &by_label->first, bytes, storage}
+    );
+}
+
+void MemoryTracker::remove(const void *handle) {
+    auto guard = lock_guard(lock);
+    auto found = allocations.find(handle);
+    if (found == allocations.end()) {
+        LOG_WARN("releasing untracked object");
+        return;
+    }
+    auto &allocation = found->second;
+    shrink(categories[(size_t)allocation.category], allocation.bytes);
+    shrink(labels.find(*allocation.label)->second, allocation.bytes);
+    shrink(totals, allocation.bytes);
+    allocations.erase(found);
+}
+
+MemoryUsage MemoryTracker::total() const {
+    auto guard = lock_guard(lock);
+    return totals;
+}
+
+MemoryUsage MemoryTracker::usage(MemoryCategory category) const {
+    auto guard = lock_guard(lock);
+    return categories[(size_t)category];
+}
+
+void MemoryTracker::report(bool per_label) const {
+    auto guard = lock_guard(lock);
+    size_t largest = 0;
+    size_t largest_storage = 0;
+    for (auto &[handle, allocation] : allocations) {
+        largest = max(largest, allocation.bytes);
+        if (allocation.storage) {
+            largest_storage = max(largest_storage, allocation.bytes);
+        }
+    }
+
+    LOG_INFO(
+        "memory: {} bytes in {} objects, peak {} bytes, largest buffer {} "
+        "of {}, largest storage binding {} of {}",
+        totals.bytes,
+        totals.live,
+        totals.peak_bytes,
+        largest,
+        limits.maxBufferSize,
+        largest_storage,
+        limits.maxStorageBufferBindingSize
+    );
+    for (size_t i = 0; i < MEMORY_CATEGORY_COUNT; i++) {
+        auto &usage = categories[i];
+        if (!usage.created) {
+            continue;
+        }
+        LOG_UNLIMITED(
+            LogLevel::Info,
+            "  {}: {} bytes, peak {}, {} live, {} created, {} released",
+            magic_enum::enum_name((MemoryCategory)i),
+            usage.bytes,
+            usage.peak_bytes,
+            usage.live,
+            usage.created,
+            usage.released
+        );
+    }
+    if (!per_label) {
+        return;
+    }
+    for (auto &[label, usage] : labels) {
+        LOG_UNLIMITED(
+            LogLevel::Info,
+            "    {}: {} bytes, peak {}, {} live, {} created, {} released",
+            label,
+            usage.bytes,
+            usage.peak_bytes,
+            usage.live,
+            usage.created,
+            usage.released
+        );
+    }
+}
+
+size_t MemoryTracker::report_leaks() const {
+    auto guard = lock_guard(lock);
+    for (auto &[handle, allocation] : allocations) {
+        LOG_UNLIMITED(
+            LogLevel::Warn,
+            "leaked {} {} of {} bytes",
+            magic_enum::enum_name(allocation.category),
+            *allocation.label,
+            allocation.bytes
+        );
+    }
+    return allocations.size();
+}
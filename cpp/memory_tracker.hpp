@@ -0,0 +1,108 @@
+#pragma once
+
+#include "./pool_allocator.hpp"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <webgpu/webgpu.h>
+
+using namespace std;
+
+enum class MemoryCategory : uint8_t {
+    Geometry,
+    Instances,
+    Overlay,
+    Attachments,
+    /* Timestamp query results and their readback */
+    Queries,
+    /* CPU memory kept for uploads, e.g. the scene */
+    Host,
+};
+
+constexpr size_t MEMORY_CATEGORY_COUNT = 6;
+
+struct MemoryUsage {
+    size_t bytes;
+    size_t peak_bytes;
+    size_t live;
+    /* Growing together while `live` stays flat is churn */
+    size_t created;
+    size_t released;
+};
+
+/*
+ * Creates and releases buffers and textures, keeping byte counts, peaks and
+ * live objects per category and per label. Sizes are checked against the
+ * device limits on creation. Thread safe, the overlay pass allocates on a
+ * worker. Objects still alive on destruction are logged as leaks.
+ */
+class MemoryTracker {
+  public:
+    explicit MemoryTracker(const WGPULimits &limits);
+    ~MemoryTracker();
+
+    MemoryTracker(const MemoryTracker &) = delete;
+    MemoryTracker &operator=(const MemoryTracker &) = delete;
+
+    WGPUBuffer create_buffer(
+        WGPUDevice device,
+        const WGPUBufferDescriptor &desc,
+        MemoryCategory category
+    );
+    void release_buffer(WGPUBuffer buffer);
+    WGPUTexture create_texture(
+        WGPUDevice device,
+        const WGPUTextureDescriptor &desc,
+        MemoryCategory category
+    );
+    void release_texture(WGPUTexture texture);
+    /* Sets the host bytes held under `label`, 0 releases them */
+    void set_host(string_view label, size_t bytes);
+
+    MemoryUsage total() const;
+    MemoryUsage usage(MemoryCategory category) const;
+    /* Logs usage per category, and per label when asked, against limits */
+    void report(bool per_label = false) const;
+    /* Logs objects still alive and returns their count */
+    size_t report_leaks() const;
+
+  private:
+    struct Allocation {
+        MemoryCategory category;
+        /* Key in `labels`, which never erases */
+        const string *label;
+        size_t bytes;
+        bool storage;
+    };
+    using AllocationMap = unordered_map<
+        const void *,
+        Allocation,
+        hash<const void *>,
+        equal_to<const void *>,
+        PoolAllocator<pair<const void *const, Allocation>>>;
+
+    void add(
+        const void *handle,
+        MemoryCategory category,
+        string_view label,
+        size_t bytes,
+        bool storage
+    );
+    void remove(const void *handle);
+    map<string, MemoryUsage, less<>>::iterator find_label(string_view label);
+
+    WGPULimits limits;
+    mutable mutex lock;
+    /* Records of created objects come from a pool, churn stays off the heap */
+    NodePool nodes;
+    AllocationMap allocations = AllocationMap(nodes);
+    map<string, size_t, less<>> host;
+    array<MemoryUsage, MEMORY_CATEGORY_COUNT> categories = {};
+    map<string, MemoryUsage, less<>> labels;
+    MemoryUsage totals = {};
+};
@@ -0,0 +1,60 @@
+#include "./options.hpp"
+#include <algorithm>
+#include <cmath>
+#include <format>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+using namespace std;
+
+static WGPUPresentMode parse_present_mode(string_view value) {
+    if (value == "fifo") {
+        return WGPUPresentMode_Fifo;
+    } else if (value == "mailbox") {
+        return WGPUPresentMode_Mailbox;
+    } else if (value == "immediate") {
+        return WGPUPresentMode_Immediate;
+    }
+    throw runtime_error(format("unknown present mode '{}'", value));
+}
+
+Options parse_options(int argc, char **argv) {
+    auto options = Options();
+    for (int i = 1; i < argc; i++) {
+        auto arg = string_view(argv[i]);
+        auto value = [&]() {
+            if (i + 1 >= argc) {
+                throw runtime_error(format("missing value for {}", arg));
+            }
+            return string_view(argv[++i]);
+        };
+
+        if (arg == "--present-mode") {
+            options.present_mode = parse_present_mode(value());
+        } else if (arg == "--fps") {
+            auto fps = value();
+            auto target_fps = 0.0;
+            try {
+                target_fps = stod(string(fps));
+            } catch (logic_error &) {
+                throw runtime_error(format("invalid fps '{}'", fps));
+            }
+            if (!isfinite(target_fps) || target_fps <= 0) {
+                throw runtime_error(format("invalid fps '{}'", fps));
+            }
+            options.target_fps = clamp(target_fps, MIN_FPS, MAX_FPS);
+        } else if (arg == "--on-demand") {
+            options.on_demand = true;
+        } else if (arg == "--scene") {
+            options.scene_path = value();
+        } else if (arg == "--capture") {
+            options.capture_path = value();
+        } else if (arg == "--replay") {
+            options.replay_path = value();
+        } else {
+            throw runtime_error(format("unknown option '{}'", arg));
+        }
+    }
+    return options;
+}
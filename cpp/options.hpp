@@ -0,0 +1,27 @@
+#pragma once
+
+#include <string>
+#include <webgpu/webgpu.h>
+
+using namespace std;
+
+/* --fps is clamped to this range */
+constexpr double MIN_FPS = 1;
+constexpr double MAX_FPS = 1000;
+
+struct Options {
+    WGPUPresentMode present_mode = WGPUPresentMode_Fifo;
+    /* 0 leaves the frame rate to the present mode */
+    double target_fps = 0;
+    /* Only render when input, animation or a shader reload changed it */
+    bool on_demand = false;
+    /* Binary scene to load instead of the built-in grid */
+    string scene_path;
+    /* Records input, uploads and draws of every frame */
+    string capture_path;
+    /* Re-executes a capture headless instead of opening a window */
+    string replay_path;
+};
+
+/* Throws runtime_error on unknown or malformed arguments */
+Options parse_options(int argc, char **argv);
@@ -0,0 +1,317 @@
+#include "./pipeline.hpp"
+#include "./log.hpp"
+#include "./batcher.hpp"
+#include "./draw_sort.hpp"
+#include "./shape.hpp"
+#include "./uniform_batches.hpp"
+#include <algorithm>
+#include <format>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+optional<string> try_read_shader(const char *path) {
+    auto file = ifstream(path);
+    if (!file.is_open()) {
+        return nullopt;
+    }
+    auto buffer = stringstream();
+    buffer << file.rdbuf();
+    return buffer.str();
+}
+
+string read_shader(const char *path) {
+    auto code = try_read_shader(path);
+    if (!code) {
+        throw runtime_error("shader not found");
+    }
+    return *code;
+}
+
+static WGPURenderPipeline create_pipeline(
+    WGPUDevice device,
+    WGPUTextureFormat texture_format,
+    const string &code,
+    WGPUPipelineLayout layout,
+    RenderPass pass,
+    const char *vertex_entry_point,
+    const WGPUVertexBufferLayout &vertex_buffer_layout
+) {
+    wgpuDevicePushErrorScope(device, WGPUErrorFilter_Validation);
+
+    WGPUShaderModuleWGSLDescriptor shader_code_desc = {
+        .chain =
+            {
+                .sType = WGPUSType_ShaderModuleWGSLDescriptor,
+            },
+        .code = code.data(),
+    };
+    auto shader_descriptor = WGPUShaderModuleDescriptor{
+        .nextInChain = &shader_code_desc.chain,
+    };
+    auto shader_module =
+        wgpuDeviceCreateShaderModule(device, &shader_descriptor);
+
+    WGPUBlendState blend_state = {
+        .color =
+            {
+                .operation = WGPUBlendOperation_Add,
+                .srcFactor = WGPUBlendFactor_SrcAlpha,
+                .dstFactor = WGPUBlendFactor_OneMinusSrcAlpha,
+            },
+        .alpha =
+            {
+                .operation = WGPUBlendOperation_Add,
+                .srcFactor = WGPUBlendFactor_Zero,
+                .dstFactor = WGPUBlendFactor_One,
+            },
+    };
+    auto transparent = pass == RenderPass::Transparent;
+    WGPUColorTargetState color_target = {
+        .format = texture_format,
+        .blend = transparent ? &blend_state : nullptr,
+        .writeMask = WGPUColorWriteMask_All,
+    };
+    WGPUFragmentState fragment_state{
+        .module = shader_module,
+        .entryPoint = "fs_main",
+        .targetCount = 1,
+        .targets = &color_target,
+    };
+
+    /* Transparent draws are sorted back to front and only test depth */
+    WGPUStencilFaceState stencil_face = {
+        .compare = WGPUCompareFunction_Always,
+        .failOp = WGPUStencilOperation_Keep,
+        .depthFailOp = WGPUStencilOperation_Keep,
+        .passOp = WGPUStencilOperation_Keep,
+    };
+    WGPUDepthStencilState depth_stencil_state = {
+        .format = DEPTH_FORMAT,
+        .depthWriteEnabled = !transparent,
+        .depthCompare = WGPUCompareFunction_LessEqual,
+        .stencilFront = stencil_face,
+        .stencilBack = stencil_face,
+        .stencilReadMask = 0,
+        .stencilWriteMask = 0,
+    };
+
+    WGPURenderPipelineDescriptor pipeline_desc = {
+        .layout = layout,
+        .vertex =
+            {
+                .module = shader_module,
+                .entryPoint = vertex_entry_point,
+                .bufferCount = 1,
+                .buffers = &vertex_buffer_layout,
+            },
+        .primitive =
+            {
+                .topology = WGPUPrimitiveTopology_TriangleList,
+                .stripIndexFormat = WGPUIndexFormat_Undefined,
+                .frontFace = WGPUFrontFace_CCW,
+                .cullMode = WGPUCullMode_None,
+            },
+        .depthStencil = &depth_stencil_state,
+        .multisample =
+            {
+                .count = 1,
+                .mask = ~0u,
+                .alphaToCoverageEnabled = false,
+            },
+        .fragment = &fragment_state,
+    };
+
+    auto render_pipeline =
+        wgpuDeviceCreateRenderPipeline(device, &pipeline_desc);
+    wgpuShaderModuleRelease(shader_module);
+
+    auto failed = false;
+    wgpuDevicePopErrorScope(
+        device,
+        [](WGPUErrorType type, char const *message, void *user_data) {
+            if (type == WGPUErrorType_NoError) {
+                return;
+            }
+            LOG_ERROR("pipeline error: {}", message);
+            *static_cast<bool *>(user_data) = true;
+        },
+        &failed
+    );
+    if (failed) {
+        wgpuRenderPipelineRelease(render_pipeline);
+        return nullptr;
+    }
+    return render_pipeline;
+}
+
+WGPUBindGroupLayout create_instance_bind_group_layout(
+    WGPUDevice device, const RenderStrategy &strategy
+) {
+    if (strategy.instance_data == InstanceData::Uniform) {
+        WGPUBindGroupLayoutEntry batch_entry = {
+            .binding = 3,
+            .visibility = WGPUShaderStage_Vertex,
+            .buffer =
+                {
+                    .type = WGPUBufferBindingType_Uniform,
+                    .hasDynamicOffset = true,
+                    .minBindingSize = UniformBatches::batch_size(
+                        strategy.max_batch_instances
+                    ),
+                },
+        };
+        WGPUBindGroupLayoutDescriptor layout_desc = {
+            .label = "instance_batch_layout",
+            .entryCount = 1,
+            .entries = &batch_entry,
+        };
+        return wgpuDeviceCreateBindGroupLayout(device, &layout_desc);
+    }
+
+    auto storage_entry = [](uint32_t binding) {
+        return WGPUBindGroupLayoutEntry{
+            .binding = binding,
+            .visibility = WGPUShaderStage_Vertex,
+            .buffer =
+                {
+                    .type = WGPUBufferBindingType_ReadOnlyStorage,
+                    .hasDynamicOffset = false,
+                    .minBindingSize = 0,
+                },
+        };
+    };
+    WGPUBindGroupLayoutEntry entries[] = {
+        storage_entry(0),
+        storage_entry(1),
+        storage_entry(2),
+    };
+    WGPUBindGroupLayoutDescriptor layout_desc = {
+        .label = "instance_bind_group_layout",
+        .entryCount = sizeof(entries) / sizeof(WGPUBindGroupLayoutEntry),
+        .entries = entries,
+    };
+    return wgpuDeviceCreateBindGroupLayout(device, &layout_desc);
+}
+
+WGPURenderPipeline create_render_pipeline(
+    WGPUDevice device,
+    WGPUTextureFormat texture_format,
+    const string &code,
+    WGPUPipelineLayout layout,
+    RenderPass pass,
+    InstanceData instance_data
+) {
+    WGPUVertexAttribute vertex_attributes[] = {
+        {
+            .format = WGPUVertexFormat_Float32x4,
+            .offset = 0,
+            .shaderLocation = 0,
+        },
+        {
+            .format = WGPUVertexFormat_Float32x4,
+            .offset = 16,
+            .shaderLocation = 1,
+        },
+    };
+
+    WGPUVertexBufferLayout vertex_buffer_layout = {
+        .arrayStride = sizeof(Vertex),
+        .stepMode = WGPUVertexStepMode_Vertex,
+        .attributeCount =
+            sizeof(vertex_attributes) / sizeof(WGPUVertexAttribute),
+        .attributes = vertex_attributes,
+    };
+    return create_pipeline(
+        device,
+        texture_format,
+        code,
+        layout,
+        pass,
+        instance_data == InstanceData::Uniform ? "vs_main_uniform" : "vs_main",
+        vertex_buffer_layout
+    );
+}
+
+WGPURenderPipeline create_quad_pipeline(
+    WGPUDevice device, WGPUTextureFormat texture_format, const string &code
+) {
+    /* Transform columns then color, matching QuadInstance */
+    constexpr uint32_t ATTRIBUTE_COUNT = sizeof(QuadInstance) / sizeof(Vec4);
+    WGPUVertexAttribute instance_attributes[ATTRIBUTE_COUNT];
+    for (uint32_t i = 0; i < ATTRIBUTE_COUNT; i++) {
+        instance_attributes[i] = {
+            .format = WGPUVertexFormat_Float32x4,
+            .offset = i * sizeof(Vec4),
+            .shaderLocation = i,
+        };
+    }
+
+    WGPUVertexBufferLayout instance_buffer_layout = {
+        .arrayStride = sizeof(QuadInstance),
+        .stepMode = WGPUVertexStepMode_Instance,
+        .attributeCount = ATTRIBUTE_COUNT,
+        .attributes = instance_attributes,
+    };
+    return create_pipeline(
+        device,
+        texture_format,
+        code,
+        nullptr,
+        RenderPass::Transparent,
+        "vs_quad",
+        instance_buffer_layout
+    );
+}
+
+bool create_pipelines(
+    WGPUDevice device,
+    WGPUTextureFormat texture_format,
+    const string &code,
+    WGPUPipelineLayout layout,
+    const RenderStrategy &strategy,
+    Pipelines &pipelines
+) {
+    /* Array sizes in WGSL are constants, so the batch size is prepended */
+    auto uniform = strategy.instance_data == InstanceData::Uniform;
+    auto batch_instances = uniform ? max(strategy.max_batch_instances, 1u) : 1;
+    auto module_code =
+        format("const UNIFORM_BATCH_INSTANCES = {}u;\n", batch_instances) +
+        code;
+    auto scene_pipeline = [&](RenderPass pass) {
+        return create_render_pipeline(
+            device,
+            texture_format,
+            module_code,
+            layout,
+            pass,
+            strategy.instance_data
+        );
+    };
+    auto created = Pipelines{
+        .scene =
+            {
+                scene_pipeline(RenderPass::Opaque),
+                scene_pipeline(RenderPass::Transparent),
+            },
+        .quad = create_quad_pipeline(device, texture_format, module_code),
+    };
+    if (ranges::count(created.scene, nullptr) || !created.quad) {
+        release_pipelines(created);
+        return false;
+    }
+    pipelines = created;
+    return true;
+}
+
+void release_pipelines(Pipelines &pipelines) {
+    for (auto pipeline : pipelines.scene) {
+        if (pipeline) {
+            wgpuRenderPipelineRelease(pipeline);
+        }
+    }
+    if (pipelines.quad) {
+        wgpuRenderPipelineRelease(pipelines.quad);
+    }
+    pipelines = {};
+}
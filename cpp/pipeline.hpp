@@ -0,0 +1,63 @@
+#pragma once
+
+#include "./backend.hpp"
+#include "./capabilities.hpp"
+#include "./draw_sort.hpp"
+#include <array>
+#include <optional>
+#include <string>
+#include <webgpu/webgpu.h>
+
+using namespace std;
+
+constexpr WGPUTextureFormat DEPTH_FORMAT = WGPUTextureFormat_Depth24Plus;
+
+string read_shader(const char *path);
+/* For hot reload, where the file can briefly be missing mid-save */
+optional<string> try_read_shader(const char *path);
+
+/*
+ * Transforms, colors and draw order as read-only storage for `vs_main`, or
+ * one dynamically offset uniform batch for `vs_main_uniform`.
+ */
+WGPUBindGroupLayout create_instance_bind_group_layout(
+    WGPUDevice device, const RenderStrategy &strategy
+);
+
+/*
+ * Returns nullptr and prints the error when the shader fails validation.
+ * Opaque pipelines write depth without blending, transparent ones blend.
+ */
+WGPURenderPipeline create_render_pipeline(
+    WGPUDevice device,
+    WGPUTextureFormat texture_format,
+    const string &code,
+    WGPUPipelineLayout layout,
+    RenderPass pass,
+    InstanceData instance_data
+);
+
+/* Pipeline for QuadBatcher, drawing `vs_quad` from per-instance attributes */
+WGPURenderPipeline create_quad_pipeline(
+    WGPUDevice device, WGPUTextureFormat texture_format, const string &code
+);
+
+struct Pipelines {
+    array<WGPURenderPipeline, PIPELINE_COUNT> scene;
+    WGPURenderPipeline quad;
+};
+
+/*
+ * Compiles `code` with the strategy's uniform batch size and vertex entry
+ * point. Leaves `pipelines` untouched and returns false if any pipeline fails.
+ */
+bool create_pipelines(
+    WGPUDevice device,
+    WGPUTextureFormat texture_format,
+    const string &code,
+    WGPUPipelineLayout layout,
+    const RenderStrategy &strategy,
+    Pipelines &pipelines
+);
+
+void release_pipelines(Pipelines &pipelines);
@@ -0,0 +1,43 @@
+#include "./pool_allocator.hpp"
+#include <algorithm>
+
+static size_t size_class_of(size_t size) {
+    return (max(size, (size_t)1) - 1) / NodePool::SLOT_ALIGN;
+}
+
+void *NodePool::allocate(size_t size) {
+    if (size > MAX_SLOT) {
+        return ::operator new(size);
+    }
+    auto size_class = size_class_of(size);
+    if (!free_lists[size_class]) {
+        refill(size_class);
+    }
+    auto slot = free_lists[size_class];
+    free_lists[size_class] = slot->next;
+    live_slots++;
+    return slot;
+}
+
+void NodePool::deallocate(void *slot, size_t size) {
+    if (size > MAX_SLOT) {
+        ::operator delete(slot);
+        return;
+    }
+    auto size_class = size_class_of(size);
+    auto free_slot = static_cast<FreeSlot *>(slot);
+    free_slot->next = free_lists[size_class];
+    free_lists[size_class] = free_slot;
+    live_slots--;
+}
+
+void NodePool::refill(size_t size_class) {
+    auto slot_size = (size_class + 1) * SLOT_ALIGN;
+    auto &chunk = chunk_blocks.emplace_back(new byte[CHUNK_SIZE]);
+    for (size_t offset = 0; offset + slot_size <= CHUNK_SIZE;
+         offset += slot_size) {
+        auto slot = reinterpret_cast<FreeSlot *>(chunk.get() + offset);
+        slot->next = free_lists[size_class];
+        free_lists[size_class] = slot;
+    }
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <vector>
+
+using namespace std;
+
+/*
+ * Free lists of fixed-size slots for small engine objects such as container
+ * nodes. Slots are carved out of chunks that are kept until the pool is
+ * destroyed, so objects created and destroyed at a steady rate stop touching
+ * the heap. Sizes above MAX_SLOT go to the heap. Not thread safe.
+ */
+class NodePool {
+  public:
+    static constexpr size_t SLOT_ALIGN = 16;
+    static constexpr size_t MAX_SLOT = 256;
+    static constexpr size_t CHUNK_SIZE = 16 * 1024;
+
+    NodePool() = default;
+
+    NodePool(const NodePool &) = delete;
+    NodePool &operator=(const NodePool &) = delete;
+
+    void *allocate(size_t size);
+    void deallocate(void *slot, size_t size);
+
+    size_t live() const {
+        return live_slots;
+    }
+    size_t chunks() const {
+        return chunk_blocks.size();
+    }
+
+  private:
+    struct FreeSlot {
+        FreeSlot *next;
+    };
+    static constexpr size_t CLASS_COUNT = MAX_SLOT / SLOT_ALIGN;
+
+    void refill(size_t size_class);
+
+    array<FreeSlot *, CLASS_COUNT> free_lists = {};
+    vector<unique_ptr<byte[]>> chunk_blocks;
+    size_t live_slots = 0;
+};
+
+/* Adapts a NodePool for standard containers */
+template <typename T>
+class PoolAllocator {
+  public:
+    using value_type = T;
+    static_assert(alignof(T) <= NodePool::SLOT_ALIGN);
+
+    PoolAllocator(NodePool &pool) : pool(&pool) {
+    }
+    template <typename U>
+    PoolAllocator(const PoolAllocator<U> &other) : pool(other.pool) {
+    }
+
+    T *allocate(size_t count) {
+        return static_cast<T *>(pool->allocate(count * sizeof(T)));
+    }
+    void deallocate(T *slot, size_t count) {
+        pool->deallocate(slot, count * sizeof(T));
+    }
+
+    template <typename U>
+    bool operator==(const PoolAllocator<U> &other) const {
+        return pool == other.pool;
+    }
+
+  private:
+    template <typename U>
+    friend class PoolAllocator;
+
+    NodePool *pool;
+};
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+using namespace std;
+
+/* Single-producer single-consumer ring, capacity must be a power of two */
+template <typename T, size_t N>
+class SpscRing {
+    static_assert((N & (N - 1)) == 0, "capacity must be a power of two");
+
+  public:
+    bool push(const T &item) {
+        auto write = write_index.load(memory_order_relaxed);
+        if (write - read_index.load(memory_order_acquire) == N) {
+            return false;
+        }
+        items[write & (N - 1)] = item;
+        write_index.store(write + 1, memory_order_release);
+        return true;
+    }
+
+    bool pop(T &item) {
+        auto read = read_index.load(memory_order_relaxed);
+        if (read == write_index.load(memory_order_acquire)) {
+            return false;
+        }
+        item = items[read & (N - 1)];
+        read_index.store(read + 1, memory_order_release);
+        return true;
+    }
+
+  private:
+    alignas(64) atomic<size_t> write_index = 0;
+    alignas(64) atomic<size_t> read_index = 0;
+    array<T, N> items;
+};
+
+/*
+ * Bounded multi-producer single-consumer ring. Each slot carries a sequence
+ * number so producers claim slots with a single CAS and never block.
+ */
+template <typename T, size_t N>
+class MpscRing {
+    static_assert((N & (N - 1)) == 0, "capacity must be a power of two");
+
+  public:
+    MpscRing() {
+        for (size_t i = 0; i < N; i++) {
+            slots[i].sequence.store(i, memory_order_relaxed);
+        }
+    }
+
+    bool push(const T &item) {
+        auto write = write_index.load(memory_order_relaxed);
+        while (true) {
+            auto &slot = slots[write & (N - 1)];
+            auto sequence = slot.sequence.load(memory_order_acquire);
+            auto diff = (intptr_t)sequence - (intptr_t)write;
+            if (diff == 0) {
+                if (write_index.compare_exchange_weak(
+                        write, write + 1, memory_order_relaxed
+                    )) {
+                    slot.item = item;
+                    slot.sequence.store(write + 1, memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                write = write_index.load(memory_order_relaxed);
+            }
+        }
+    }
+
+    bool pop(T &item) {
+        auto &slot = slots[read_index & (N - 1)];
+        if (slot.sequence.load(memory_order_acquire) != read_index + 1) {
+            return false;
+        }
+        item = slot.item;
+        slot.sequence.store(read_index + N, memory_order_release);
+        read_index++;
+        return true;
+    }
+
+  private:
+    struct Slot {
+        atomic<size_t> sequence;
+        T item;
+    };
+
+    alignas(64) atomic<size_t> write_index = 0;
+    alignas(64) size_t read_index = 0;
+    array<Slot, N> slots;
+};
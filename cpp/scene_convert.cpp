@@ -0,0 +1,185 @@
+#include "./scene_file.hpp"
+#include "./shape.hpp"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <print>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace std;
+
+/*
+ * Scene converter and load benchmark.
+ *
+ *     scene_convert grid <width> <height> <out>
+ *     scene_convert text <in> <out>
+ *     scene_convert bench <instances>
+ *
+ * Text scenes have one command per line, `#` starts a comment:
+ *
+ *     mesh
+ *     vertex <x> <y> <z> <r> <g> <b> <a>
+ *     instance <tx> <ty> <sx> <sy> <rotation> <r> <g> <b> <a>
+ *
+ * Vertices and instances belong to the most recent `mesh`.
+ */
+
+static size_t parse_count(const char *value) {
+    try {
+        return stoull(value);
+    } catch (logic_error &) {
+        throw runtime_error(format("invalid count '{}'", value));
+    }
+}
+
+static SceneData read_text_scene(const filesystem::path &path) {
+    auto file = ifstream(path);
+    if (!file.is_open()) {
+        throw runtime_error(format("failed opening {}", path.string()));
+    }
+
+    auto scene = SceneData();
+    auto line = string();
+    for (size_t line_number = 1; getline(file, line); line_number++) {
+        auto stream = istringstream(line.substr(0, line.find('#')));
+        auto command = string();
+        if (!(stream >> command)) {
+            continue;
+        }
+        auto fail = [&](string_view reason) {
+            return runtime_error(
+                format("{}:{}: {}", path.string(), line_number, reason)
+            );
+        };
+
+        if (command == "mesh") {
+            scene.meshes.push_back({
+                .first_vertex = (uint32_t)scene.vertices.size(),
+                .vertex_count = 0,
+                .first_instance = (uint32_t)scene.transforms.size(),
+                .instance_count = 0,
+            });
+            continue;
+        }
+        if (scene.meshes.empty()) {
+            throw fail("expected mesh first");
+        }
+        auto &mesh = scene.meshes.back();
+
+        if (command == "vertex") {
+            float x, y, z, r, g, b, a;
+            if (!(stream >> x >> y >> z >> r >> g >> b >> a)) {
+                throw fail("vertex expects 7 numbers");
+            }
+            scene.vertices.push_back({{x, y, z, 1.0f}, {r, g, b, a}});
+            mesh.vertex_count++;
+        } else if (command == "instance") {
+            float tx, ty, sx, sy, rotation, r, g, b, a;
+            if (!(stream >> tx >> ty >> sx >> sy >> rotation >> r >> g >> b >>
+                  a)) {
+                throw fail("instance expects 9 numbers");
+            }
+            scene.transforms.push_back(
+                transform_mat4({tx, ty}, {sx, sy}, rotation)
+            );
+            scene.colors.push_back({r, g, b, a});
+            mesh.instance_count++;
+        } else {
+            throw fail(format("unknown command '{}'", command));
+        }
+    }
+    return scene;
+}
+
+using BenchClock = chrono::steady_clock;
+
+/* Keeps the touch loop from being optimised away */
+static volatile float bench_sink;
+
+static double elapsed_ms(BenchClock::time_point start) {
+    return chrono::duration<double, milli>(BenchClock::now() - start).count();
+}
+
+/* Prints `bench <name> <instances> <ms>` lines */
+static void bench(size_t instances) {
+    auto width = (size_t)ceil(sqrt((double)instances));
+    auto height = (instances + width - 1) / width;
+    auto path = filesystem::temp_directory_path() /
+                format("scene_bench_{}.blkscene", instances);
+
+    auto start = BenchClock::now();
+    auto scene = grid_scene(width, height);
+    scene.meshes[0].instance_count = instances;
+    scene.transforms.resize(instances);
+    scene.colors.resize(instances);
+    write_scene(path, scene.view());
+    println("bench write {} {:.3f}", instances, elapsed_ms(start));
+
+    /* Mapping and validation only, pages are faulted in on first use */
+    start = BenchClock::now();
+    {
+        auto file = SceneFile(path);
+        println("bench map {} {:.3f}", instances, elapsed_ms(start));
+
+        /* Touching every transform pulls the pages in, as an upload would */
+        start = BenchClock::now();
+        float sum = 0;
+        for (auto &matrix : file.view().transforms) {
+            sum += matrix[3][0];
+        }
+        println("bench touch {} {:.3f}", instances, elapsed_ms(start));
+        bench_sink = sum;
+    }
+
+    /* Baseline, reading the same file into owned memory */
+    start = BenchClock::now();
+    {
+        auto file = ifstream(path, ios::binary);
+        auto contents = vector<char>(filesystem::file_size(path));
+        file.read(contents.data(), contents.size());
+    }
+    println("bench read {} {:.3f}", instances, elapsed_ms(start));
+
+    filesystem::remove(path);
+}
+
+int main(int argc, char **argv) {
+    try {
+        auto mode = argc > 1 ? string_view(argv[1]) : string_view();
+        if (mode == "grid" && argc == 5) {
+            auto scene = grid_scene(parse_count(argv[2]), parse_count(argv[3]));
+            write_scene(argv[4], scene.view());
+        } else if (mode == "text" && argc == 4) {
+            auto scene = read_text_scene(argv[2]);
+            write_scene(argv[3], scene.view());
+        } else if (mode == "bench" && argc == 3) {
+            bench(parse_count(argv[2]));
+        } else {
+            println(stderr, "usage: scene_convert grid <width> <height> <out>");
+            println(stderr, "       scene_convert text <in> <out>");
+            println(stderr, "       scene_convert bench <instances>");
+            return 1;
+        }
+        /* Reload what was written so bad input fails here, not at startup */
+        if (mode != "bench") {
+            auto file = SceneFile(argv[argc - 1]);
+            println(
+                "wrote {}: {} meshes, {} vertices, {} instances",
+                argv[argc - 1],
+                file.view().meshes.size(),
+                file.view().vertices.size(),
+                file.view().transforms.size()
+            );
+        }
+    } catch (runtime_error &err) {
+        println(stderr, "{}", err.what());
+        return 1;
+    }
+}
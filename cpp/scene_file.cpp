@@ -0,0 +1,264 @@
+#include "./scene_file.hpp"
+#include <cstring>
+#include <format>
+#include <fstream>
+#include <stdexcept>
+#include <vector>
+
+#ifdef WINDOWS
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static size_t align_up(size_t value, size_t alignment) {
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+#ifdef WINDOWS
+
+static byte *map_file(const filesystem::path &path, size_t &size) {
+    auto file = CreateFileW(
+        path.c_str(),
+        GENERIC_READ,
+        FILE_SHARE_READ,
+        nullptr,
+        OPEN_EXISTING,
+        FILE_ATTRIBUTE_NORMAL,
+        nullptr
+    );
+    if (file == INVALID_HANDLE_VALUE) {
+        throw runtime_error(format("failed opening {}", path.string()));
+    }
+    LARGE_INTEGER file_size;
+    GetFileSizeEx(file, &file_size);
+    size = file_size.QuadPart;
+    auto mapping =
+        CreateFileMappingW(file, nullptr, PAGE_WRITECOPY, 0, 0, nullptr);
+    CloseHandle(file);
+    if (!mapping) {
+        throw runtime_error(format("failed mapping {}", path.string()));
+    }
+    auto data = MapViewOfFile(mapping, FILE_MAP_COPY, 0, 0, 0);
+    CloseHandle(mapping);
+    if (!data) {
+        throw runtime_error(format("failed mapping {}", path.string()));
+    }
+    return static_cast<byte *>(data);
+}
+
+static void unmap_file(byte *data, size_t) {
+    UnmapViewOfFile(data);
+}
+
+#else
+
+static byte *map_file(const filesystem::path &path, size_t &size) {
+    auto fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw runtime_error(format("failed opening {}", path.string()));
+    }
+    struct stat info;
+    fstat(fd, &info);
+    size = info.st_size;
+    auto data = size ? mmap(
+                           nullptr,
+                           size,
+                           PROT_READ | PROT_WRITE,
+                           MAP_PRIVATE,
+                           fd,
+                           0
+                       )
+                     : MAP_FAILED;
+    close(fd);
+    if (data == MAP_FAILED) {
+        throw runtime_error(format("failed mapping {}", path.string()));
+    }
+    return static_cast<byte *>(data);
+}
+
+static void unmap_file(byte *data, size_t size) {
+    munmap(data, size);
+}
+
+#endif
+
+template <typename T>
+static span<T> section_span(
+    byte *data, size_t size, const SceneSectionEntry *entry, const char *name
+) {
+    if (!entry) {
+        throw runtime_error(format("scene is missing {} section", name));
+    }
+    if (entry->stride != sizeof(T) || entry->offset % SCENE_ALIGNMENT ||
+        entry->offset > size ||
+        entry->count > (size - entry->offset) / sizeof(T)) {
+        throw runtime_error(format("scene {} section is malformed", name));
+    }
+    return {reinterpret_cast<T *>(data + entry->offset), entry->count};
+}
+
+SceneFile::SceneFile(const filesystem::path &path) {
+    data = map_file(path, size);
+
+    try {
+        SceneHeader header;
+        if (size < sizeof(header)) {
+            throw runtime_error("scene is truncated");
+        }
+        memcpy(&header, data, sizeof(header));
+        if (memcmp(header.magic, SCENE_MAGIC, sizeof(SCENE_MAGIC))) {
+            throw runtime_error("not a scene file");
+        }
+        if (header.version != SCENE_VERSION) {
+            throw runtime_error(
+                format("unsupported scene version {}", header.version)
+            );
+        }
+        auto table_size = header.section_count * sizeof(SceneSectionEntry);
+        if (header.file_size != size ||
+            size - sizeof(header) < table_size) {
+            throw runtime_error("scene is truncated");
+        }
+
+        auto entries = reinterpret_cast<const SceneSectionEntry *>(
+            data + sizeof(SceneHeader)
+        );
+        auto find = [&](SceneSectionType type) -> const SceneSectionEntry * {
+            for (size_t i = 0; i < header.section_count; i++) {
+                if (entries[i].type == type) {
+                    return &entries[i];
+                }
+            }
+            return nullptr;
+        };
+
+        scene = {
+            .meshes = section_span<const SceneMesh>(
+                data, size, find(SceneSectionType::Meshes), "meshes"
+            ),
+            .vertices = section_span<const Vertex>(
+                data, size, find(SceneSectionType::Vertices), "vertices"
+            ),
+            .transforms = section_span<Mat4>(
+                data, size, find(SceneSectionType::Transforms), "transforms"
+            ),
+            .colors = section_span<const Vec4>(
+                data, size, find(SceneSectionType::Colors), "colors"
+            ),
+        };
+
+        if (scene.transforms.size() != scene.colors.size()) {
+            throw runtime_error("scene transform and color counts differ");
+        }
+        for (auto &mesh : scene.meshes) {
+            if ((uint64_t)mesh.first_vertex + mesh.vertex_count >
+                    scene.vertices.size() ||
+                (uint64_t)mesh.first_instance + mesh.instance_count >
+                    scene.transforms.size()) {
+                throw runtime_error("scene mesh range out of bounds");
+            }
+        }
+    } catch (...) {
+        unmap_file(data, size);
+        throw;
+    }
+}
+
+SceneFile::~SceneFile() {
+    unmap_file(data, size);
+}
+
+SceneData grid_scene(size_t width, size_t height) {
+    auto square = SquareModel();
+    auto scene = SceneData();
+    scene.vertices.assign(begin(square.vertices), end(square.vertices));
+    scene.transforms = grid_transforms(width, height);
+    scene.colors.assign(scene.transforms.size(), Vec4(0, 0, 0, 0));
+    const Vec4 tints[] = {{1, 0, 0, 1}, {0, 1, 0, 1}, {0, 0, 1, 1}};
+    for (size_t i = 0; i < size(tints) && i < scene.colors.size(); i++) {
+        scene.colors[i] = tints[i];
+    }
+    scene.meshes.push_back({
+        .first_vertex = 0,
+        .vertex_count = (uint32_t)scene.vertices.size(),
+        .first_instance = 0,
+        .instance_count = (uint32_t)scene.transforms.size(),
+    });
+    return scene;
+}
+
+void write_scene(const filesystem::path &path, const SceneView &scene) {
+    struct Section {
+        SceneSectionType type;
+        uint32_t stride;
+        const void *data;
+        size_t count;
+    };
+    Section sections[] = {
+        {SceneSectionType::Meshes,
+         sizeof(SceneMesh),
+         scene.meshes.data(),
+         scene.meshes.size()},
+        {SceneSectionType::Vertices,
+         sizeof(Vertex),
+         scene.vertices.data(),
+         scene.vertices.size()},
+        {SceneSectionType::Transforms,
+         sizeof(Mat4),
+         scene.transforms.data(),
+         scene.transforms.size()},
+        {SceneSectionType::Colors,
+         sizeof(Vec4),
+         scene.colors.data(),
+         scene.colors.size()},
+    };
+    constexpr uint32_t SECTION_COUNT = sizeof(sections) / sizeof(Section);
+
+    auto entries = vector<SceneSectionEntry>();
+    auto offset =
+        sizeof(SceneHeader) + SECTION_COUNT * sizeof(SceneSectionEntry);
+    for (auto &section : sections) {
+        offset = align_up(offset, SCENE_ALIGNMENT);
+        entries.push_back({
+            .type = section.type,
+            .stride = section.stride,
+            .offset = offset,
+            .count = section.count,
+        });
+        offset += section.count * section.stride;
+    }
+
+    SceneHeader header = {
+        .magic = {},
+        .version = SCENE_VERSION,
+        .section_count = SECTION_COUNT,
+        .file_size = offset,
+    };
+    memcpy(header.magic, SCENE_MAGIC, sizeof(SCENE_MAGIC));
+
+    auto file = ofstream(path, ios::binary | ios::trunc);
+    if (!file.is_open()) {
+        throw runtime_error(format("failed opening {}", path.string()));
+    }
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    file.write(
+        reinterpret_cast<const char *>(entries.data()),
+        entries.size() * sizeof(SceneSectionEntry)
+    );
+    for (size_t i = 0; i < SECTION_COUNT; i++) {
+        auto padding = entries[i].offset - (size_t)file.tellp();
+        auto zeros = array<char, SCENE_ALIGNMENT>();
+        file.write(zeros.data(), padding);
+        file.write(
+            static_cast<const char *>(sections[i].data),
+            sections[i].count * sections[i].stride
+        );
+    }
+    if (!file) {
+        throw runtime_error(format("failed writing {}", path.string()));
+    }
+}
@@ -0,0 +1,109 @@
+#pragma once
+
+#include "./shape.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <span>
+#include <vector>
+
+using namespace std;
+
+/*
+ * Binary scene layout, little-endian:
+ *
+ *     SceneHeader
+ *     SceneSectionEntry[section_count]
+ *     sections, each starting on a SCENE_ALIGNMENT boundary
+ *
+ * Sections hold arrays in their in-memory layout, so a mapped file can be
+ * handed to buffer uploads without parsing.
+ */
+constexpr char SCENE_MAGIC[8] = {'B', 'L', 'K', 'S', 'C', 'E', 'N', 'E'};
+constexpr uint32_t SCENE_VERSION = 1;
+constexpr size_t SCENE_ALIGNMENT = 256;
+
+enum class SceneSectionType : uint32_t {
+    Meshes = 1,
+    Vertices = 2,
+    Transforms = 3,
+    Colors = 4,
+};
+
+struct SceneHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t section_count;
+    uint64_t file_size;
+};
+
+struct SceneSectionEntry {
+    SceneSectionType type;
+    uint32_t stride;
+    uint64_t offset;
+    uint64_t count;
+};
+
+/* A mesh and the contiguous instance range drawn with it */
+struct SceneMesh {
+    uint32_t first_vertex;
+    uint32_t vertex_count;
+    uint32_t first_instance;
+    uint32_t instance_count;
+};
+
+struct SceneView {
+    span<const SceneMesh> meshes;
+    span<const Vertex> vertices;
+    /* Writable so animations can update instances in place */
+    span<Mat4> transforms;
+    span<const Vec4> colors;
+
+    /* Instances drawn across all meshes */
+    size_t drawn_instances() const {
+        size_t count = 0;
+        for (auto &mesh : meshes) {
+            count += mesh.instance_count;
+        }
+        return count;
+    }
+};
+
+/* Scene owned in memory, for built-in scenes and the converter */
+struct SceneData {
+    vector<SceneMesh> meshes;
+    vector<Vertex> vertices;
+    vector<Mat4> transforms;
+    vector<Vec4> colors;
+
+    SceneView view() {
+        return {meshes, vertices, transforms, colors};
+    }
+};
+
+/* Grid of squares, the first three tinted red, green and blue */
+SceneData grid_scene(size_t width, size_t height);
+
+/*
+ * Memory-mapped scene. Pages are mapped copy-on-write, so only instances
+ * that are modified ever get copied. Throws runtime_error on malformed files.
+ */
+class SceneFile {
+  public:
+    explicit SceneFile(const filesystem::path &path);
+    ~SceneFile();
+
+    SceneFile(const SceneFile &) = delete;
+    SceneFile &operator=(const SceneFile &) = delete;
+
+    const SceneView &view() const {
+        return scene;
+    }
+
+  private:
+    byte *data = nullptr;
+    size_t size = 0;
+    SceneView scene;
+};
+
+void write_scene(const filesystem::path &path, const SceneView &scene);
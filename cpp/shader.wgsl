@@ -10,25 +10,73 @@ struct VertexOut {
     @location(0) color : vec4f,
 }
 
-struct UniformData {
-    model_transformations: array<mat4x4f, 16>,
-    model_colors: array<vec4f, 16>,
+@group(0) @binding(0)
+var<storage, read> model_transformations: array<mat4x4f>;
+
+@group(0) @binding(1)
+var<storage, read> model_colors: array<vec4f>;
+
+@group(0) @binding(2)
+var<storage, read> instance_order: array<u32>;
+
+// Fallback for devices without vertex storage buffers: one batch of
+// instances gathered in draw order, bound at a dynamic offset per batch.
+// UNIFORM_BATCH_INSTANCES is defined by the app, see create_pipelines.
+struct InstanceBatch {
+    transforms: array<mat4x4f, UNIFORM_BATCH_INSTANCES>,
+    colors: array<vec4f, UNIFORM_BATCH_INSTANCES>,
 }
 
-@group(0) @binding(0)
-var<uniform> uniform_data: UniformData;
+@group(0) @binding(3)
+var<uniform> instance_batch: InstanceBatch;
 
-@vertex
-fn vs_main(vertex_in: VertexIn, @builtin(instance_index) instance_index: u32) -> VertexOut {
-    let model_transformation = uniform_data.model_transformations[instance_index];
-    let model_color = uniform_data.model_colors[instance_index];
+fn instance_vertex(vertex_in: VertexIn, model_transformation: mat4x4f, model_color: vec4f) -> VertexOut {
     let position = model_transformation * vertex_in.position;
     let color = select(
         model_color, vertex_in.color, dot(model_color, model_color) == 0
     );
     return VertexOut(position, color);
 }
+
+@vertex
+fn vs_main(vertex_in: VertexIn, @builtin(instance_index) instance_index: u32) -> VertexOut {
+    let instance = instance_order[instance_index];
+    return instance_vertex(
+        vertex_in, model_transformations[instance], model_colors[instance]
+    );
+}
+
+@vertex
+fn vs_main_uniform(vertex_in: VertexIn, @builtin(instance_index) instance_index: u32) -> VertexOut {
+    return instance_vertex(
+        vertex_in,
+        instance_batch.transforms[instance_index],
+        instance_batch.colors[instance_index]
+    );
+}
     
+struct QuadIn {
+    @location(0) transform_0 : vec4f,
+    @location(1) transform_1 : vec4f,
+    @location(2) transform_2 : vec4f,
+    @location(3) transform_3 : vec4f,
+    @location(4) color : vec4f,
+}
+
+@vertex
+fn vs_quad(quad: QuadIn, @builtin(vertex_index) vertex_index: u32) -> VertexOut {
+    // Same unit square as SquareModel
+    var corners = array<vec2f, 6>(
+        vec2f(0.0, 0.0), vec2f(0.0, 1.0), vec2f(-1.0, 0.0),
+        vec2f(-1.0, 1.0), vec2f(-1.0, 0.0), vec2f(0.0, 1.0),
+    );
+    let transform = mat4x4f(
+        quad.transform_0, quad.transform_1, quad.transform_2, quad.transform_3
+    );
+    let position = transform * vec4f(corners[vertex_index], 0.5, 1.0);
+    return VertexOut(position, quad.color);
+}
+
 @fragment
 fn fs_main(vertex_info: VertexOut) -> @location(0) vec4f {
     return vertex_info.color;
@@ -1,4 +1,5 @@
 #include "./shape.hpp"
+#include <cmath>
 #include <cstring>
 
 /* Column-major for WGSL */
@@ -153,3 +154,52 @@ SquareModel::SquareModel() {
         .color = {0.0, 0.0, 1.0, 1.0},
     };
 };
+
+Mat4 transform_mat4(
+    const Vec2 &translation, const Vec2 &scale, float rotation
+) {
+    /*
+     * translate * rotate * scale
+     * {{
+     *     {s[0] * cos, s[0] * sin, 0.0, 0.0},
+     *     {-s[1] * sin, s[1] * cos, 0.0, 0.0},
+     *     {0.0, 0.0, 1.0, 0.0},
+     *     {t[0], t[1], 0.0, 1.0},
+     * }};
+     */
+
+    auto cosr = cos(rotation);
+    auto sinr = sin(rotation);
+    auto result = mat4();
+    result[0][0] = scale[0] * cosr;
+    result[0][1] = scale[0] * sinr;
+    result[1][0] = -scale[1] * sinr;
+    result[1][1] = scale[1] * cosr;
+    result[3][0] = translation[0];
+    result[3][1] = translation[1];
+    return result;
+}
+
+vector<Mat4> grid_transforms(size_t width, size_t height) {
+    float wgsl_width = 2.0 / width;
+    float wgsl_height = 2.0 / height;
+    float temp_translate_x = width / 2.0 - 1;
+    float temp_translate_y = height / 2.0 - 1;
+    auto grid_origin_matrix =
+        scale_mat4(mat4(), {wgsl_width, wgsl_height, 1.0});
+    grid_origin_matrix = translate_mat4(
+        grid_origin_matrix,
+        {-wgsl_width * temp_translate_x, wgsl_height * temp_translate_y, 0.0}
+    );
+
+    auto matrix_data = vector<Mat4>(width * height);
+    for (size_t j = 0; j < height; j++) {
+        for (size_t i = 0; i < width; i++) {
+            auto model_matrix = translate_mat4(
+                grid_origin_matrix, {wgsl_width * i, -wgsl_height * j, 0.0}
+            );
+            matrix_data[j * width + i] = model_matrix;
+        }
+    }
+    return matrix_data;
+}
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <array>
+#include <vector>
 
 using namespace std;
 
@@ -103,3 +104,10 @@ Mat4 mat4(float d = 1);
 Mat4 translate_mat4(const Mat4 &matrix, const Vec3 &translation);
 
 Vec4 mat_multiply(const Mat4 matrix, const Vec4 vec);
+
+Mat4 transform_mat4(
+    const Vec2 &translation, const Vec2 &scale, float rotation
+);
+
+/* Unit squares tiling clip space, row-major from the top left */
+vector<Mat4> grid_transforms(size_t width, size_t height);
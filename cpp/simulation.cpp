@@ -0,0 +1,153 @@
+#include "./simulation.hpp"
+#include <GLFW/glfw3.h>
+#include <numbers>
+
+constexpr float TWEEN_SECONDS = 0.25;
+
+Simulation::Simulation(const SceneView &scene) : scene(scene) {
+    transforms.track(scene.transforms.data(), scene.transforms.size());
+}
+
+bool Simulation::update(
+    float now, span<const InputEvent> events, FrameBackend &backend
+) {
+    auto changed = !uploaded;
+    if (!uploaded) {
+        backend.write_buffer(
+            BufferId::Vertices,
+            0,
+            scene.vertices.data(),
+            scene.vertices.size_bytes()
+        );
+        backend.write_buffer(
+            BufferId::Transforms,
+            0,
+            scene.transforms.data(),
+            scene.transforms.size_bytes()
+        );
+        backend.write_buffer(
+            BufferId::Colors, 0, scene.colors.data(), scene.colors.size_bytes()
+        );
+        uploaded = true;
+    }
+
+    for (auto &event : events) {
+        if (event.type == InputType::Key && event.action == GLFW_PRESS) {
+            animate_key(event.code, now);
+        }
+    }
+
+    animator.update(now, transforms);
+    auto dirty = transforms.write_dirty();
+    if (dirty.count) {
+        backend.write_buffer(
+            BufferId::Transforms,
+            dirty.first * sizeof(Mat4),
+            &scene.transforms[dirty.first],
+            dirty.count * sizeof(Mat4)
+        );
+    }
+    if (changed || dirty.count) {
+        sort_instances(backend);
+    }
+    return changed || dirty.count > 0;
+}
+
+void Simulation::draw(FrameBackend &backend) const {
+    for (auto &draw : draws) {
+        backend.draw(draw);
+    }
+}
+
+void Simulation::sort_instances(FrameBackend &backend) {
+    keys.clear();
+    order.clear();
+    for (uint32_t mesh_index = 0; mesh_index < scene.meshes.size();
+         mesh_index++) {
+        auto &mesh = scene.meshes[mesh_index];
+        auto end = mesh.first_instance + mesh.instance_count;
+        for (auto instance = mesh.first_instance; instance < end; instance++) {
+            auto &color = scene.colors[instance];
+            /* A zero color falls back to the opaque vertex colors */
+            auto zero = !color[0] && !color[1] && !color[2] && !color[3];
+            auto transparent = color[3] < 1 && !zero;
+            auto pass =
+                transparent ? RenderPass::Transparent : RenderPass::Opaque;
+            auto pipeline =
+                transparent ? PipelineId::Transparent : PipelineId::Opaque;
+            auto depth = scene.transforms[instance][3][2];
+            keys.push_back(
+                make_sort_key(pass, (uint32_t)pipeline, depth, mesh_index)
+            );
+            order.push_back(instance);
+        }
+    }
+    sorter.sort(keys, order);
+
+    /* Runs of one pipeline and mesh become one instanced draw */
+    sorted_draws.clear();
+    for (size_t first = 0; first < keys.size();) {
+        auto pipeline = sort_key_pipeline(keys[first]);
+        auto mesh_index = sort_key_material(keys[first]);
+        auto last = first + 1;
+        while (last < keys.size() &&
+               sort_key_pipeline(keys[last]) == pipeline &&
+               sort_key_material(keys[last]) == mesh_index) {
+            last++;
+        }
+        auto &mesh = scene.meshes[mesh_index];
+        sorted_draws.push_back({
+            .vertex_count = mesh.vertex_count,
+            .instance_count = (uint32_t)(last - first),
+            .first_vertex = mesh.first_vertex,
+            .first_instance = (uint32_t)first,
+            .pipeline = (PipelineId)pipeline,
+        });
+        first = last;
+    }
+
+    if (sorted_draws != draws) {
+        swap(draws, sorted_draws);
+        generation++;
+    }
+
+    if (order != uploaded_order) {
+        backend.write_buffer(
+            BufferId::Order, 0, order.data(), order.size() * sizeof(uint32_t)
+        );
+        uploaded_order = order;
+    }
+}
+
+bool Simulation::handles_key(int key) {
+    return key == GLFW_KEY_W || key == GLFW_KEY_A || key == GLFW_KEY_S ||
+           key == GLFW_KEY_D;
+}
+
+bool Simulation::animating() const {
+    return animator.active() > 0;
+}
+
+void Simulation::animate_key(int key, float now) {
+    /* Unmapped keys must not decompose every instance */
+    if (!handles_key(key)) {
+        return;
+    }
+    auto scaling = key == GLFW_KEY_A || key == GLFW_KEY_D;
+    auto factor = key == GLFW_KEY_A ? 1.25 : 0.8;
+    auto turn = key == GLFW_KEY_W ? numbers::pi / 20 : numbers::pi / 2;
+    for (uint32_t i = 0; i < transforms.size(); i++) {
+        auto tween = [&](Channel channel, float to) {
+            animator.add(transforms, i, channel, to, now, TWEEN_SECONDS);
+        };
+        if (scaling) {
+            auto scale_x = transforms.get(i, Channel::ScaleX);
+            auto scale_y = transforms.get(i, Channel::ScaleY);
+            tween(Channel::ScaleX, scale_x * factor);
+            tween(Channel::ScaleY, scale_y * factor);
+        } else {
+            auto rotation = transforms.get(i, Channel::Rotation);
+            tween(Channel::Rotation, rotation + turn);
+        }
+    }
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include "./animation.hpp"
+#include "./backend.hpp"
+#include "./draw_sort.hpp"
+#include "./input.hpp"
+#include "./scene_file.hpp"
+#include <span>
+#include <vector>
+
+using namespace std;
+
+/*
+ * Per-frame scene logic, kept free of window and device state so captured
+ * frames can be re-executed headless against any backend.
+ */
+class Simulation {
+  public:
+    explicit Simulation(const SceneView &scene);
+
+    /*
+     * Applies key presses and advances animations to `now`, uploading what
+     * changed. The first call uploads the whole scene. Returns true when
+     * anything was uploaded.
+     */
+    bool update(
+        float now, span<const InputEvent> events, FrameBackend &backend
+    );
+
+    void draw(FrameBackend &backend) const;
+
+    /* True for keys whose press starts an animation */
+    static bool handles_key(int key);
+
+    bool animating() const;
+
+    /* Changes whenever the draws emitted by `draw` change */
+    uint64_t draw_generation() const {
+        return generation;
+    }
+
+  private:
+    void animate_key(int key, float now);
+    /* Rebuilds the draw order and uploads it if it changed */
+    void sort_instances(FrameBackend &backend);
+
+    SceneView scene;
+    InstanceTransforms transforms;
+    Animator animator;
+    bool uploaded = false;
+
+    RadixSorter sorter;
+    vector<uint64_t> keys;
+    vector<uint32_t> order;
+    vector<uint32_t> uploaded_order;
+    vector<DrawCall> draws;
+    vector<DrawCall> sorted_draws;
+    uint64_t generation = 0;
+};
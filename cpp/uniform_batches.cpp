@@ -0,0 +1,141 @@
+#include "./uniform_batches.hpp"
+#include "./capabilities.hpp"
+#include <cstring>
+
+UniformBatches::UniformBatches(
+    span<const Mat4> transforms,
+    span<const Vec4> colors,
+    size_t drawn_instances,
+    uint32_t batch_instances,
+    uint32_t alignment
+)
+    : transforms(transforms), colors(colors),
+      instances_per_batch(max(batch_instances, 1u)),
+      slots(transforms.size(), NOT_DRAWN) {
+    auto align = max<uint64_t>(alignment, 1);
+    stride = (batch_size(instances_per_batch) + align - 1) / align * align;
+    auto batches = (drawn_instances + instances_per_batch - 1) /
+                   instances_per_batch;
+    batches = max<size_t>(batches, 1);
+    staging.resize((batches - 1) * stride + batch_size(instances_per_batch));
+}
+
+uint64_t UniformBatches::batch_size(uint32_t batch_instances) {
+    return batch_instances * UNIFORM_INSTANCE_BYTES;
+}
+
+void UniformBatches::write(
+    BufferId buffer, uint64_t offset, size_t size, const void *data
+) {
+    switch (buffer) {
+    case BufferId::Transforms: {
+        auto first = offset / sizeof(Mat4);
+        for (auto i = first; i < first + size / sizeof(Mat4); i++) {
+            pack_transform((uint32_t)i);
+        }
+        break;
+    }
+    case BufferId::Colors: {
+        auto first = offset / sizeof(Vec4);
+        for (auto i = first; i < first + size / sizeof(Vec4); i++) {
+            pack_color((uint32_t)i);
+        }
+        break;
+    }
+    case BufferId::Order: {
+        /* A new draw order moves instances between slots, repack them all */
+        auto first = offset / sizeof(uint32_t);
+        auto count = size / sizeof(uint32_t);
+        order.resize(max(order.size(), first + count));
+        memcpy(order.data() + first, data, size);
+        ranges::fill(slots, NOT_DRAWN);
+        for (uint32_t slot = 0; slot < order.size(); slot++) {
+            slots[order[slot]] = slot;
+        }
+        for (auto instance : order) {
+            pack_transform(instance);
+            pack_color(instance);
+        }
+        break;
+    }
+    case BufferId::Vertices:
+        break;
+    }
+}
+
+span<const byte> UniformBatches::take_dirty(uint64_t &offset) {
+    if (dirty_begin >= dirty_end) {
+        return {};
+    }
+    offset = dirty_begin;
+    auto dirty = span(staging).subspan(dirty_begin, dirty_end - dirty_begin);
+    dirty_begin = UINT64_MAX;
+    dirty_end = 0;
+    return dirty;
+}
+
+void UniformBatches::pack_transform(uint32_t instance) {
+    auto slot = slots[instance];
+    if (slot == NOT_DRAWN) {
+        return;
+    }
+    auto batch = slot / instances_per_batch;
+    auto index = slot % instances_per_batch;
+    auto position = batch * stride + index * sizeof(Mat4);
+    memcpy(&staging[position], &transforms[instance], sizeof(Mat4));
+    mark_dirty(position, position + sizeof(Mat4));
+}
+
+void UniformBatches::pack_color(uint32_t instance) {
+    auto slot = slots[instance];
+    if (slot == NOT_DRAWN) {
+        return;
+    }
+    auto batch = slot / instances_per_batch;
+    auto index = slot % instances_per_batch;
+    auto position = batch * stride + instances_per_batch * sizeof(Mat4) +
+                    index * sizeof(Vec4);
+    memcpy(&staging[position], &colors[instance], sizeof(Vec4));
+    mark_dirty(position, position + sizeof(Vec4));
+}
+
+void UniformBatches::mark_dirty(uint64_t begin, uint64_t end) {
+    dirty_begin = min(dirty_begin, begin);
+    dirty_end = max(dirty_end, end);
+}
+
+WgpuUniformBackend::WgpuUniformBackend(
+    WGPUQueue queue,
+    WGPUBuffer vertex_buffer,
+    WGPUBuffer batch_buffer,
+    WGPUBindGroup bind_group,
+    UniformBatches &batches
+)
+    : WgpuBackend(queue, {vertex_buffer, nullptr, nullptr, nullptr}),
+      batch_buffer(batch_buffer), bind_group(bind_group), batches(batches) {
+}
+
+void WgpuUniformBackend::write_buffer(
+    BufferId buffer, uint64_t offset, const void *data, size_t size
+) {
+    if (buffer == BufferId::Vertices) {
+        WgpuBackend::write_buffer(buffer, offset, data, size);
+        return;
+    }
+    batches.write(buffer, offset, size, data);
+    uint64_t dirty_offset = 0;
+    auto dirty = batches.take_dirty(dirty_offset);
+    if (!dirty.empty()) {
+        wgpuQueueWriteBuffer(
+            queue, batch_buffer, dirty_offset, dirty.data(), dirty.size()
+        );
+    }
+}
+
+void WgpuUniformBackend::draw(const DrawCall &draw) {
+    batches.split(draw, [&](uint32_t batch, const DrawCall &piece) {
+        auto offset = batches.batch_offset(batch);
+        wgpuRenderBundleEncoderSetBindGroup(bundle, 0, bind_group, 1, &offset);
+        WgpuBackend::draw(piece);
+    });
+}
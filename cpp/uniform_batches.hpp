@@ -0,0 +1,113 @@
+#pragma once
+
+#include "./backend.hpp"
+#include "./shape.hpp"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+using namespace std;
+
+/*
+ * Instance data for devices without vertex storage buffers. Transforms and
+ * colors are gathered in draw order into batches of `batch_instances`, each
+ * laid out as the `InstanceBatch` uniform block of shader.wgsl and bound at
+ * its own dynamic offset, so a draw indexes its batch directly.
+ *
+ * Uploads of the scene's instance buffers are applied here instead: the
+ * scene arrays are read back by instance and the changed batch bytes are
+ * left for the backend to copy to the device.
+ */
+class UniformBatches {
+  public:
+    UniformBatches(
+        span<const Mat4> transforms,
+        span<const Vec4> colors,
+        size_t drawn_instances,
+        uint32_t batch_instances,
+        uint32_t alignment
+    );
+
+    /* Bytes of one bound batch, transforms then colors */
+    static uint64_t batch_size(uint32_t batch_instances);
+
+    uint32_t batch_instances() const {
+        return instances_per_batch;
+    }
+    uint32_t batch_offset(uint32_t batch) const {
+        return (uint32_t)(batch * stride);
+    }
+    /* Bytes of the buffer holding every batch */
+    uint64_t buffer_size() const {
+        return staging.size();
+    }
+
+    /*
+     * Calls `draw_batch(batch, piece)` for each part of `draw` within one
+     * batch, `piece.first_instance` relative to the batch.
+     */
+    template <typename F>
+    void split(const DrawCall &draw, F &&draw_batch) const {
+        auto first = draw.first_instance;
+        auto end = draw.first_instance + draw.instance_count;
+        while (first < end) {
+            auto batch = first / instances_per_batch;
+            auto batch_start = batch * instances_per_batch;
+            auto last = min(end, batch_start + instances_per_batch);
+            auto piece = draw;
+            piece.instance_count = last - first;
+            piece.first_instance = first - batch_start;
+            draw_batch(batch, piece);
+            first = last;
+        }
+    }
+
+    /* Applies an upload of Transforms, Colors or Order */
+    void write(BufferId buffer, uint64_t offset, size_t size, const void *data);
+    /* Batch bytes changed since the last call, `offset` into the buffer */
+    span<const byte> take_dirty(uint64_t &offset);
+
+  private:
+    static constexpr uint32_t NOT_DRAWN = UINT32_MAX;
+
+    void pack_transform(uint32_t instance);
+    void pack_color(uint32_t instance);
+    void mark_dirty(uint64_t begin, uint64_t end);
+
+    span<const Mat4> transforms;
+    span<const Vec4> colors;
+    uint32_t instances_per_batch;
+    uint64_t stride;
+    /* Instance indices in draw order, and the slot of each instance */
+    vector<uint32_t> order;
+    vector<uint32_t> slots;
+    vector<byte> staging;
+    uint64_t dirty_begin = UINT64_MAX;
+    uint64_t dirty_end = 0;
+};
+
+/* WgpuBackend for the uniform path, drawing each batch at its offset */
+class WgpuUniformBackend : public WgpuBackend {
+  public:
+    /* `bind_group` binds `batch_buffer` as the `instance_batch` block */
+    WgpuUniformBackend(
+        WGPUQueue queue,
+        WGPUBuffer vertex_buffer,
+        WGPUBuffer batch_buffer,
+        WGPUBindGroup bind_group,
+        UniformBatches &batches
+    );
+
+    void write_buffer(
+        BufferId buffer, uint64_t offset, const void *data, size_t size
+    ) override;
+    /* Splits draws at batch boundaries */
+    void draw(const DrawCall &draw) override;
+
+  private:
+    WGPUBuffer batch_buffer;
+    WGPUBindGroup bind_group;
+    UniformBatches &batches;
+};
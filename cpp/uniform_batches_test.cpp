@@ -0,0 +1,155 @@
+#include "./capabilities.hpp"
+#include "./simulation.hpp"
+#include "./uniform_batches.hpp"
+#include <GLFW/glfw3.h>
+#include <cstring>
+#include <print>
+#include <vector>
+
+using namespace std;
+
+/*
+ * Animates the built-in grid through UniformBatches and checks that every
+ * batch holds the transforms and colors of its instances in draw order, and
+ * that draws are split at batch boundaries.
+ *
+ *     uniform_batches_test
+ *
+ * Prints every failed check to stderr and exits with 1 if any failed.
+ */
+
+static int failures = 0;
+
+static void check(bool passed, const string &name) {
+    if (!passed) {
+        println(stderr, "FAIL {}", name);
+        failures++;
+    }
+}
+
+/* Small batches with padding between them, like a downlevel device */
+constexpr uint32_t BATCH_INSTANCES = 5;
+constexpr uint32_t ALIGNMENT = 256;
+
+/* Stands in for the device: batch bytes land in `device`, draws are split */
+class BatchBackend : public FrameBackend {
+  public:
+    explicit BatchBackend(UniformBatches &batches)
+        : batches(batches), device(batches.buffer_size()) {
+    }
+
+    void write_buffer(
+        BufferId buffer, uint64_t offset, const void *data, size_t size
+    ) override {
+        batches.write(buffer, offset, size, data);
+        uint64_t dirty_offset = 0;
+        auto dirty = batches.take_dirty(dirty_offset);
+        memcpy(device.data() + dirty_offset, dirty.data(), dirty.size());
+        if (buffer == BufferId::Order) {
+            order.assign(
+                (const uint32_t *)data,
+                (const uint32_t *)data + size / sizeof(uint32_t)
+            );
+        }
+    }
+
+    void draw(const DrawCall &draw) override {
+        auto instances = 0u;
+        batches.split(draw, [&](uint32_t batch, const DrawCall &piece) {
+            auto slot = batch * BATCH_INSTANCES + piece.first_instance;
+            check(
+                slot == draw.first_instance + instances,
+                "pieces continue the draw"
+            );
+            check(
+                piece.first_instance + piece.instance_count <= BATCH_INSTANCES,
+                "piece within its batch"
+            );
+            instances += piece.instance_count;
+        });
+        check(instances == draw.instance_count, "pieces cover the draw");
+    }
+
+    UniformBatches &batches;
+    vector<byte> device;
+    vector<uint32_t> order;
+};
+
+/* Compares every slot of the device buffer with the scene */
+static bool packed(const BatchBackend &backend, const SceneView &scene) {
+    for (uint32_t slot = 0; slot < backend.order.size(); slot++) {
+        auto instance = backend.order[slot];
+        auto batch = slot / BATCH_INSTANCES;
+        auto index = slot % BATCH_INSTANCES;
+        auto base = backend.device.data() + backend.batches.batch_offset(batch);
+        auto transform = base + index * sizeof(Mat4);
+        auto color =
+            base + BATCH_INSTANCES * sizeof(Mat4) + index * sizeof(Vec4);
+        if (memcmp(transform, &scene.transforms[instance], sizeof(Mat4)) ||
+            memcmp(color, &scene.colors[instance], sizeof(Vec4))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void test_layout() {
+    check(
+        UniformBatches::batch_size(BATCH_INSTANCES) ==
+            BATCH_INSTANCES * UNIFORM_INSTANCE_BYTES,
+        "batch size"
+    );
+    auto scene = grid_scene(4, 4);
+    auto batches = UniformBatches(
+        scene.transforms, scene.colors, 16, BATCH_INSTANCES, ALIGNMENT
+    );
+    check(batches.batch_offset(1) == 512, "batch offsets aligned");
+    check(
+        batches.buffer_size() ==
+            3 * 512 + UniformBatches::batch_size(BATCH_INSTANCES),
+        "buffer ends after the last batch"
+    );
+}
+
+/* Scales and spins the grid, so transforms and the draw order change */
+static void test_animation() {
+    auto scene = grid_scene(4, 4);
+    auto view = scene.view();
+    auto batches = UniformBatches(
+        view.transforms,
+        view.colors,
+        view.drawn_instances(),
+        BATCH_INSTANCES,
+        ALIGNMENT
+    );
+    auto backend = BatchBackend(batches);
+    auto simulation = Simulation(view);
+    InputEvent presses[] = {
+        {.type = InputType::Key, .code = GLFW_KEY_A, .action = GLFW_PRESS},
+        {.type = InputType::Key, .code = GLFW_KEY_W, .action = GLFW_PRESS},
+    };
+    for (int frame = 0; frame < 40; frame++) {
+        auto now = frame / 60.0f;
+        auto events = span<const InputEvent>();
+        if (frame == 2 || frame == 20) {
+            events = {&presses[frame / 20], 1};
+        }
+        simulation.update(now, events, backend);
+        simulation.draw(backend);
+        check(
+            backend.order.size() == view.drawn_instances(),
+            format("frame {} order uploaded", frame)
+        );
+        check(packed(backend, view), format("frame {} packed", frame));
+    }
+}
+
+int main() {
+    test_layout();
+    test_animation();
+    if (failures) {
+        println(stderr, "{} checks failed", failures);
+        return 1;
+    }
+    println("all checks passed");
+}
@@ -0,0 +1,61 @@
+#include "./worker_pool.hpp"
+#include <algorithm>
+
+WorkerPool::WorkerPool(size_t threads) {
+    auto thread_count =
+        threads ? threads : max(1u, thread::hardware_concurrency());
+    for (size_t i = 1; i < thread_count; i++) {
+        this->threads.emplace_back([this] { work(); });
+    }
+}
+
+WorkerPool::~WorkerPool() {
+    {
+        auto guard = lock_guard(lock);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (auto &thread : threads) {
+        thread.join();
+    }
+}
+
+void WorkerPool::run(size_t count, const function<void(size_t)> &job) {
+    auto guard = unique_lock(lock);
+    this->job = &job;
+    this->count = count;
+    next = 0;
+    finished = 0;
+    generation++;
+    wake.notify_all();
+
+    drain(guard);
+    done.wait(guard, [&] { return finished == count; });
+    this->job = nullptr;
+}
+
+void WorkerPool::work() {
+    auto guard = unique_lock(lock);
+    uint64_t seen = 0;
+    while (true) {
+        wake.wait(guard, [&] { return stopping || generation != seen; });
+        if (stopping) {
+            return;
+        }
+        seen = generation;
+        drain(guard);
+    }
+}
+
+void WorkerPool::drain(unique_lock<mutex> &guard) {
+    while (next < count) {
+        auto index = next++;
+        auto &current = *job;
+        guard.unlock();
+        current(index);
+        guard.lock();
+        if (++finished == count) {
+            done.notify_all();
+        }
+    }
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+/* Persistent threads running indexed jobs, the calling thread helps out */
+class WorkerPool {
+  public:
+    /* 0 uses the hardware concurrency */
+    explicit WorkerPool(size_t threads = 0);
+    ~WorkerPool();
+
+    WorkerPool(const WorkerPool &) = delete;
+    WorkerPool &operator=(const WorkerPool &) = delete;
+
+    /* Calls `job(i)` for every i below `count` and waits for all of them */
+    void run(size_t count, const function<void(size_t)> &job);
+
+  private:
+    void work();
+    /* Runs claimed jobs until none are left, `guard` is held on return */
+    void drain(unique_lock<mutex> &guard);
+
+    mutex lock;
+    condition_variable wake;
+    condition_variable done;
+    const function<void(size_t)> *job = nullptr;
+    size_t count = 0;
+    size_t next = 0;
+    size_t finished = 0;
+    uint64_t generation = 0;
+    bool stopping = false;
+    vector<thread> threads;
+};